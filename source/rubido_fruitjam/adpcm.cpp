@@ -0,0 +1,35 @@
+// adpcm.cpp - IMA ADPCM tables and block decoder
+
+#include "adpcm.h"
+
+const int16_t adpcm_step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+const int8_t adpcm_index_table[8] = {
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+void adpcmDecode(const uint8_t* data, uint32_t first, uint32_t count, AdpcmState* state, int16_t* out) {
+    uint32_t index = first;
+    // Odd start, take the high nibble on its own
+    if ((index & 1) && count > 0) {
+        *out++ = adpcmDecodeSample(state, data[index >> 1] >> 4);
+        index++;
+        count--;
+    }
+    // Two samples per byte
+    const uint8_t* p = data + (index >> 1);
+    while (count >= 2) {
+        uint8_t byte = *p++;
+        *out++ = adpcmDecodeSample(state, byte & 0x0F);
+        *out++ = adpcmDecodeSample(state, byte >> 4);
+        count -= 2;
+    }
+    if (count) *out = adpcmDecodeSample(state, *p & 0x0F);
+}
@@ -0,0 +1,47 @@
+#ifndef ADPCM_H
+#define ADPCM_H
+
+#include <stdint.h>
+
+// IMA ADPCM decoding, 4 bits per 16 bit sample, low nibble first.
+// A clip is one stream without block headers, the state before the first
+// sample is stored next to the data (see AudioSample in audiomixer.h).
+// Encode clips with tools/samples/mksamples.py.
+// Typical usage:
+//   AdpcmState state = { sample->predictor, sample->step_index };
+//   for (uint32_t i = 0; i < sample->length; i++)
+//     out[i] = adpcmDecodeSample(&state, adpcmNibble(sample->data, i));
+
+struct AdpcmState {
+    int32_t predictor;
+    int32_t step_index;     // 0-88
+};
+
+extern const int16_t adpcm_step_table[89];
+extern const int8_t adpcm_index_table[8];
+
+static inline uint8_t adpcmNibble(const uint8_t* data, uint32_t index) {
+    return (data[index >> 1] >> ((index & 1) << 2)) & 0x0F;
+}
+
+static inline int16_t adpcmDecodeSample(AdpcmState* state, uint8_t nibble) {
+    int32_t step = adpcm_step_table[state->step_index];
+    int32_t diff = step >> 3;
+    if (nibble & 4) diff += step;
+    if (nibble & 2) diff += step >> 1;
+    if (nibble & 1) diff += step >> 2;
+    int32_t predictor = state->predictor + ((nibble & 8) ? -diff : diff);
+    if (predictor > 32767) predictor = 32767;
+    if (predictor < -32768) predictor = -32768;
+    state->predictor = predictor;
+
+    int32_t index = state->step_index + adpcm_index_table[nibble & 7];
+    if (index < 0) index = 0;
+    if (index > 88) index = 88;
+    state->step_index = index;
+    return (int16_t)predictor;
+}
+
+// Decodes count samples starting at sample first, state must be the state before first
+void adpcmDecode(const uint8_t* data, uint32_t first, uint32_t count, AdpcmState* state, int16_t* out);
+#endif
@@ -0,0 +1,1250 @@
+// audiomixer.cpp - block based tone mixer, the hardware independent part of i2stones
+// Each voice is loaded into locals once per block and runs a tight loop over the
+// block, the mix is then scaled and written as interleaved stereo in one pass
+
+#include "audiomixer.h"
+#include "notetables.h"
+#include "adpcm.h"
+#include <string.h>
+#include <math.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#define AUDIO_CYCLES() rp2040.getCycleCount()
+#else
+#include <time.h>
+static uint32_t hostNanoseconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+#define AUDIO_CYCLES() hostNanoseconds()
+#endif
+
+static uint32_t sample_rate = 44100;
+
+// ============================================================================
+// Mixer state, only touched by the output side (audio interrupt)
+// ============================================================================
+
+#define ENVELOPE_FULL (1 << 24)     // envelope levels are Q24
+#define ENVELOPE_MIN_RELEASE 64     // samples, stopping a voice never clicks
+
+enum EnvelopeStage {
+    ENV_ATTACK,
+    ENV_DECAY,
+    ENV_SUSTAIN,
+    ENV_RELEASE,
+    ENV_DONE
+};
+
+struct AudioVoice {
+    const int16_t* table;
+    uint32_t phase;
+    uint32_t phase_increment;
+    uint16_t amplitude;
+    uint32_t duration_samples;
+    uint32_t samples_played;
+    uint32_t start_sample;
+    int16_t pan_left;           // constant power pan gains, Q14
+    int16_t pan_right;
+
+    // ADSR, stepped once per block, the mixer ramps linearly in between
+    int32_t env_level;
+    int32_t env_rate;           // change per sample in the current stage
+    uint32_t env_left;          // samples left in the current stage
+    uint32_t release_at;        // samples_played where the release starts (voices with a duration)
+    uint32_t attack_samples;
+    uint32_t decay_samples;
+    uint32_t release_samples;
+    int32_t sustain_level;
+    uint8_t env_stage;
+
+    // Sample clip, NULL for tones. phase / phase_increment are then the position
+    // in the clip and the step per output sample, both with a 16 bit fraction
+    const uint8_t* sample_data;
+    uint32_t sample_length;
+    uint32_t sample_next;       // samples decoded so far, s1 is sample_next - 1
+    AdpcmState adpcm;
+    int16_t s0;
+    int16_t s1;
+    uint16_t sample_rate;
+
+    // Track (sound bank notes) the voice is working through, 0 events left for plain tones
+    const uint8_t* track_next;
+    const AudioEnvelope* track_envelopes;
+    uint32_t track_start;       // sample clock of tick 0
+    uint16_t track_amplitude;
+    int8_t track_pan;
+    uint8_t track_left;
+
+    bool active;
+    bool scheduled;
+};
+
+static AudioVoice voices[MAX_CHANNELS];
+
+// Track which channels are active (or scheduled) to speed up mixing
+static uint8_t active_channel_indices[MAX_CHANNELS];
+static uint8_t active_channel_count = 0;
+static bool active_list_dirty = false;
+static uint32_t voice_busy[AUDIO_VOICE_MASK_WORDS];  // bit per active or scheduled voice
+
+static uint32_t sample_clock = 0;  // frames rendered
+static AudioBlockHook volatile block_hook = NULL;
+
+// ============================================================================
+// Shared between the game thread and the mixer
+// ============================================================================
+
+enum AudioCommandType {
+    AUDIO_CMD_START,
+    AUDIO_CMD_SCHEDULE,
+    AUDIO_CMD_TRACK,
+    AUDIO_CMD_SAMPLE,
+    AUDIO_CMD_SET_VOLUME,
+    AUDIO_CMD_SET_PITCH,
+    AUDIO_CMD_SET_PAN,
+    AUDIO_CMD_STOP,
+    AUDIO_CMD_CANCEL,
+    AUDIO_CMD_STOP_ALL
+};
+
+struct AudioCommand {
+    uint8_t type;
+    uint8_t channel;
+    uint32_t start_sample;     // delay for start, track and sample, sample clock for schedule
+    AudioVoiceParams params;   // amplitude / pan only for set volume, set pan and track, phase_increment is the pitch of samples
+    const AudioSample* sample;
+    const uint8_t* track_events;
+    const AudioEnvelope* track_envelopes;
+    uint8_t track_count;
+    uint32_t trigger_frame;    // frames pulled when it was queued, for the latency stats
+};
+
+// Single producer / single consumer queue, the indexes only ever increase.
+// The producer only writes command_head, the mixer only writes command_tail.
+static AudioCommand command_queue[AUDIO_COMMAND_QUEUE_SIZE];
+static uint32_t command_head = 0;
+static uint32_t command_tail = 0;
+static uint32_t command_write = 0;     // producer position, ahead of command_head inside a batch
+static uint8_t command_batch_depth = 0;
+
+// Published by the mixer after every block: voice bits, then the number of
+// commands they include (release), the game thread reads in the opposite order
+static volatile uint32_t published_busy[AUDIO_VOICE_MASK_WORDS];     // playing or scheduled
+static volatile uint32_t published_playing[AUDIO_VOICE_MASK_WORDS];
+static volatile uint8_t published_active_count = 0;
+static volatile uint8_t published_playing_count = 0;
+static volatile uint32_t published_sample_clock = 0;
+static uint32_t published_commands = 0;
+
+// Game thread only: queue position of the last start / schedule per channel,
+// which doubles as its age for voice stealing, and what stealing looks at
+static uint32_t channel_last_start[MAX_CHANNELS];
+static uint16_t channel_amplitude[MAX_CHANNELS];
+static uint8_t channel_priority[MAX_CHANNELS];
+static uint32_t pending_starts[AUDIO_VOICE_MASK_WORDS];  // starts the mixer may not have published yet
+static uint32_t reserved_voices[AUDIO_VOICE_MASK_WORDS];  // kept for the block hook
+static uint32_t steal_count = 0;
+
+// Ring of rendered blocks, indexes only ever increase (wrap at 256)
+// Frames are packed left in the low, right in the high half, so one store writes both
+static uint32_t ring[AUDIO_RING_BLOCKS][AUDIO_BLOCK_FRAMES];
+static volatile uint8_t ring_read = 0;
+static volatile uint8_t ring_write = 0;
+
+// Software clock state
+static uint32_t soft_clock_last_us = 0;
+static uint64_t soft_clock_frames_x1M = 0;  // frames owed, scaled by 1000000
+
+// Rate lock: the frames the output pulled are counted against the system timer,
+// every window gives a measured output rate and the correction (nominal / measured)
+// that scales all phase increments, so pitch follows the real output clock.
+#define AUDIO_RATE_WINDOW_US 1000000
+#define AUDIO_RATE_CORRECTION_MIN (AUDIO_RATE_CORRECTION_UNITY - AUDIO_RATE_CORRECTION_UNITY / 16)
+#define AUDIO_RATE_CORRECTION_MAX (AUDIO_RATE_CORRECTION_UNITY + AUDIO_RATE_CORRECTION_UNITY / 16)
+static volatile uint32_t pulled_frames = 0;    // frames handed to the output
+static bool rate_started = false;
+static uint32_t rate_window_us = 0;
+static uint32_t rate_window_frames = 0;
+static uint32_t rate_windows = 0;
+static volatile uint32_t measured_rate_q8 = 0;     // Hz, 8 bit fraction, 0 until measured
+static volatile uint32_t rate_correction = AUDIO_RATE_CORRECTION_UNITY;
+static uint32_t block_rate_correction = AUDIO_RATE_CORRECTION_UNITY;   // for the block being rendered
+
+// Timing stats, written by the audio interrupt, read by audioMixerGetTimingStats.
+// Latency is kept in frames and only converted when read.
+static uint32_t output_latency_frames = 0;
+static volatile bool timing_reset = false;
+static volatile uint32_t latency_count = 0;
+static volatile uint32_t latency_min_frames = 0xFFFFFFFFu;
+static volatile uint32_t latency_max_frames = 0;
+static volatile uint32_t latency_last_frames = 0;
+static volatile uint64_t latency_sum_frames = 0;
+static volatile uint32_t block_count = 0;
+static volatile uint32_t block_cycles_min = 0xFFFFFFFFu;
+static volatile uint32_t block_cycles_max = 0;
+static volatile uint64_t block_cycles_sum = 0;
+static volatile uint32_t fill_histogram[AUDIO_FILL_BUCKETS];
+
+// Mix bus: voices add up at full scale, a single voice at amplitude 255 reaches
+// full scale on its own. The master gain scales the sum, below the knee the samples
+// pass unchanged, above it the soft clip table bends the headroom (up to
+// 2^AUDIO_MIX_HEADROOM_BITS times full scale) smoothly into full scale instead of
+// clipping. Levels no longer depend on how many voices play.
+#define AUDIO_CLIP_KNEE 24576
+#define AUDIO_MASTER_GAIN_MAX 512
+#define AUDIO_CLIP_RANGE ((32768 << AUDIO_MIX_HEADROOM_BITS) - AUDIO_CLIP_KNEE)
+#define AUDIO_CLIP_SHIFT 8
+#define AUDIO_CLIP_TABLE_SIZE ((AUDIO_CLIP_RANGE >> AUDIO_CLIP_SHIFT) + 1)
+static int16_t clip_table[AUDIO_CLIP_TABLE_SIZE + 1];
+static volatile uint16_t master_gain = AUDIO_MASTER_GAIN_DEFAULT;
+// Dither noise, restarted by audioMixerInit so a render is the same every run
+#define AUDIO_DITHER_SEED_LEFT 0x12345678
+#define AUDIO_DITHER_SEED_RIGHT 0x9E3779B9
+static uint32_t dither_left = AUDIO_DITHER_SEED_LEFT;
+static uint32_t dither_right = AUDIO_DITHER_SEED_RIGHT;
+
+static void buildClipTable() {
+    // tanh curve with slope 1 at the knee, approaching full scale at the end of the headroom
+    const float span = 32767.0f - AUDIO_CLIP_KNEE;
+    for (int i = 0; i <= AUDIO_CLIP_TABLE_SIZE; i++) {
+        float over = (float)(i << AUDIO_CLIP_SHIFT) / span;
+        clip_table[i] = (int16_t)lrintf(AUDIO_CLIP_KNEE + span * tanhf(over));
+    }
+}
+
+// Only called above the knee, interpolates between two table entries
+static inline int32_t softClip(int32_t x) {
+    int32_t over = (x < 0 ? -x : x) - AUDIO_CLIP_KNEE;
+    int32_t index = over >> AUDIO_CLIP_SHIFT;
+    int32_t y;
+    if (index >= AUDIO_CLIP_TABLE_SIZE) {
+        y = clip_table[AUDIO_CLIP_TABLE_SIZE];
+    } else {
+        int32_t a = clip_table[index];
+        y = a + (((clip_table[index + 1] - a) * (over & ((1 << AUDIO_CLIP_SHIFT) - 1))) >> AUDIO_CLIP_SHIFT);
+    }
+    return x < 0 ? -y : y;
+}
+
+// Constant power pan, Q14: entry i is sin(i / AUDIO_PAN_STEPS * pi / 2) * sqrt(2),
+// right reads it at pan + 127, left mirrored. Both sides are unity in the center
+// and the power left + right stays the same anywhere in between.
+#define AUDIO_PAN_STEPS 254
+#define AUDIO_PAN_UNITY 16384
+static int16_t pan_table[AUDIO_PAN_STEPS + 1];
+
+static void buildPanTable() {
+    for (int i = 0; i <= AUDIO_PAN_STEPS; i++) {
+        float angle = (float)i * 1.5707963f / AUDIO_PAN_STEPS;
+        pan_table[i] = (int16_t)lrintf(sinf(angle) * 1.4142136f * AUDIO_PAN_UNITY);
+    }
+}
+
+// One extra entry repeats the first, so interpolation never has to wrap
+static int16_t wavetables[WAVE_COUNT][WAVETABLE_SIZE + 1];
+
+static void buildWavetables() {
+    static bool built = false;
+    if (built) return;
+    uint32_t noise = 0x2545F491;
+    for (int i = 0; i < WAVETABLE_SIZE; i++) {
+        // square and saw a bit lower so the waveforms sound about equally loud
+        wavetables[WAVE_SINE][i] = (int16_t)lrintf(sinf(i * 6.2831853f / WAVETABLE_SIZE) * 32767.0f);
+        wavetables[WAVE_SQUARE][i] = i < WAVETABLE_SIZE / 2 ? 24576 : -24576;
+        int32_t tri = (i < WAVETABLE_SIZE / 2) ? i : WAVETABLE_SIZE - i;   // 0 .. size/2
+        wavetables[WAVE_TRIANGLE][i] = (int16_t)((tri * 4 * 32767) / WAVETABLE_SIZE - 32767);
+        wavetables[WAVE_SAW][i] = (int16_t)((i * 2 * 24576) / WAVETABLE_SIZE - 24576);
+        noise ^= noise << 13;
+        noise ^= noise >> 17;
+        noise ^= noise << 5;
+        wavetables[WAVE_NOISE][i] = (int16_t)(noise >> 16);
+    }
+    for (int w = 0; w < WAVE_COUNT; w++) {
+        wavetables[w][WAVETABLE_SIZE] = wavetables[w][0];
+    }
+    built = true;
+}
+
+void audioMixerInit(uint32_t sample_rate_arg) {
+    sample_rate = sample_rate_arg;
+    buildWavetables();
+    buildClipTable();
+    buildPanTable();
+    memset(voices, 0, sizeof(voices));
+    active_channel_count = 0;
+    active_list_dirty = false;
+    sample_clock = 0;
+
+    command_head = 0;
+    command_tail = 0;
+    command_write = 0;
+    command_batch_depth = 0;
+    published_commands = 0;
+    memset(voice_busy, 0, sizeof(voice_busy));
+    memset(channel_last_start, 0, sizeof(channel_last_start));
+    memset(channel_amplitude, 0, sizeof(channel_amplitude));
+    memset(channel_priority, AUDIO_PRIORITY_NORMAL, sizeof(channel_priority));
+    memset(pending_starts, 0, sizeof(pending_starts));
+    memset(reserved_voices, 0, sizeof(reserved_voices));
+    block_hook = NULL;
+    steal_count = 0;
+    for (int i = 0; i < AUDIO_VOICE_MASK_WORDS; i++) {
+        published_busy[i] = 0;
+        published_playing[i] = 0;
+    }
+    published_active_count = 0;
+    published_playing_count = 0;
+    published_sample_clock = 0;
+
+    ring_read = 0;
+    ring_write = 0;
+    soft_clock_frames_x1M = 0;
+    pulled_frames = 0;
+    rate_started = false;
+    rate_windows = 0;
+    measured_rate_q8 = 0;
+    rate_correction = AUDIO_RATE_CORRECTION_UNITY;
+    timing_reset = true;
+    dither_left = AUDIO_DITHER_SEED_LEFT;
+    dither_right = AUDIO_DITHER_SEED_RIGHT;
+}
+
+uint32_t audioMixerGetSampleRate() {
+    return sample_rate;
+}
+
+// ============================================================================
+// Voices (game thread)
+// ============================================================================
+
+static bool pushCommand(const AudioCommand* cmd) {
+    uint32_t head = command_write;
+    uint32_t tail = __atomic_load_n(&command_tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= AUDIO_COMMAND_QUEUE_SIZE) return false;
+
+    command_queue[head & (AUDIO_COMMAND_QUEUE_SIZE - 1)] = *cmd;
+    command_queue[head & (AUDIO_COMMAND_QUEUE_SIZE - 1)].trigger_frame = pulled_frames;
+
+    uint8_t channel = cmd->channel;
+    if (cmd->type == AUDIO_CMD_START || cmd->type == AUDIO_CMD_SCHEDULE ||
+        cmd->type == AUDIO_CMD_TRACK || cmd->type == AUDIO_CMD_SAMPLE) {
+        channel_last_start[channel] = head + 1;
+        channel_amplitude[channel] = cmd->params.amplitude;
+        pending_starts[channel >> 5] |= 1u << (channel & 31);
+    } else if (cmd->type == AUDIO_CMD_SET_VOLUME) {
+        channel_amplitude[channel] = cmd->params.amplitude;
+    }
+    command_write = head + 1;
+    if (command_batch_depth == 0) {
+        __atomic_store_n(&command_head, command_write, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+static bool pushSimpleCommand(uint8_t type, uint8_t channel, uint16_t amplitude) {
+    AudioCommand cmd = {};
+    cmd.type = type;
+    cmd.channel = channel;
+    cmd.params.amplitude = amplitude;
+    return pushCommand(&cmd);
+}
+
+void audioMixerBeginBatch() {
+    command_batch_depth++;
+}
+
+void audioMixerEndBatch() {
+    if (command_batch_depth == 0) return;
+    if (--command_batch_depth == 0) {
+        __atomic_store_n(&command_head, command_write, __ATOMIC_RELEASE);
+    }
+}
+
+bool audioMixerStartVoice(uint8_t channel, const AudioVoiceParams* params, uint32_t delay_samples) {
+    if (channel >= MAX_CHANNELS) return false;
+    AudioCommand cmd;
+    cmd.type = AUDIO_CMD_START;
+    cmd.channel = channel;
+    cmd.start_sample = delay_samples;
+    cmd.params = *params;
+    return pushCommand(&cmd);
+}
+
+bool audioMixerScheduleVoice(uint8_t channel, const AudioVoiceParams* params, uint32_t start_sample) {
+    if (channel >= MAX_CHANNELS) return false;
+    AudioCommand cmd;
+    cmd.type = AUDIO_CMD_SCHEDULE;
+    cmd.channel = channel;
+    cmd.start_sample = start_sample;
+    cmd.params = *params;
+    return pushCommand(&cmd);
+}
+
+bool audioMixerStartTrack(uint8_t channel, const uint8_t* events, uint8_t event_count,
+                          const AudioEnvelope* envelopes, uint16_t amplitude, int8_t pan, uint32_t delay_samples) {
+    if (channel >= MAX_CHANNELS || event_count == 0) return false;
+    AudioCommand cmd = {};
+    cmd.type = AUDIO_CMD_TRACK;
+    cmd.channel = channel;
+    cmd.start_sample = delay_samples;
+    cmd.params.amplitude = amplitude;
+    cmd.params.pan = pan;
+    cmd.track_events = events;
+    cmd.track_envelopes = envelopes;
+    cmd.track_count = event_count;
+    return pushCommand(&cmd);
+}
+
+bool audioMixerStartSample(uint8_t channel, const AudioSample* sample, uint32_t pitch,
+                           uint16_t amplitude, int8_t pan, uint32_t delay_samples) {
+    if (channel >= MAX_CHANNELS || !sample || sample->length < 2) return false;
+    // No attack, the clip has its own, stopping still fades out
+    static const AudioEnvelope sample_envelope = { 0, 0, 255, 0 };
+    AudioCommand cmd = {};
+    cmd.type = AUDIO_CMD_SAMPLE;
+    cmd.channel = channel;
+    cmd.start_sample = delay_samples;
+    cmd.params.phase_increment = pitch;
+    cmd.params.amplitude = amplitude;
+    cmd.params.envelope = sample_envelope;
+    cmd.params.pan = pan;
+    cmd.sample = sample;
+    return pushCommand(&cmd);
+}
+
+bool audioMixerSetVoiceVolume(uint8_t channel, uint16_t amplitude) {
+    if (channel >= MAX_CHANNELS) return false;
+    return pushSimpleCommand(AUDIO_CMD_SET_VOLUME, channel, amplitude);
+}
+
+bool audioMixerSetVoicePan(uint8_t channel, int8_t pan) {
+    if (channel >= MAX_CHANNELS) return false;
+    AudioCommand cmd = {};
+    cmd.type = AUDIO_CMD_SET_PAN;
+    cmd.channel = channel;
+    cmd.params.pan = pan;
+    return pushCommand(&cmd);
+}
+
+bool audioMixerSetSamplePitch(uint8_t channel, uint32_t pitch) {
+    if (channel >= MAX_CHANNELS) return false;
+    AudioCommand cmd = {};
+    cmd.type = AUDIO_CMD_SET_PITCH;
+    cmd.channel = channel;
+    cmd.params.phase_increment = pitch;
+    return pushCommand(&cmd);
+}
+
+bool audioMixerStopVoice(uint8_t channel) {
+    if (channel >= MAX_CHANNELS) return false;
+    return pushSimpleCommand(AUDIO_CMD_STOP, channel, 0);
+}
+
+bool audioMixerCancelVoice(uint8_t channel) {
+    if (channel >= MAX_CHANNELS) return false;
+    return pushSimpleCommand(AUDIO_CMD_CANCEL, channel, 0);
+}
+
+bool audioMixerStopAll() {
+    return pushSimpleCommand(AUDIO_CMD_STOP_ALL, 0, 0);
+}
+
+// Started or scheduled by a command the mixer has not published yet
+static inline bool startPending(uint8_t channel, uint32_t done) {
+    return (int32_t)(channel_last_start[channel] - done) > 0;
+}
+
+static inline bool maskBit(volatile uint32_t* mask, uint8_t channel) {
+    return (mask[channel >> 5] >> (channel & 31)) & 1;
+}
+
+// Index of the lowest set bit, CLZ is a single instruction on the Cortex-M33
+static inline uint8_t lowestBit(uint32_t bits) {
+    return 31 - __builtin_clz(bits & (0u - bits));
+}
+
+static inline uint32_t validBits(int word) {
+    int bits = MAX_CHANNELS - word * 32;
+    return bits >= 32 ? 0xFFFFFFFFu : ((1u << bits) - 1);
+}
+
+// Busy voices plus starts still on their way to the mixer, drops the starts
+// the mixer has published meanwhile
+static uint32_t claimedBits(int word, uint32_t done) {
+    uint32_t pending = pending_starts[word];
+    uint32_t bits = pending;
+    while (bits) {
+        uint8_t bit = lowestBit(bits);
+        bits &= bits - 1;
+        if (!startPending(word * 32 + bit, done)) pending &= ~(1u << bit);
+    }
+    pending_starts[word] = pending;
+    return published_busy[word] | pending;
+}
+
+int8_t audioMixerFindFreeVoice() {
+    uint32_t done = __atomic_load_n(&published_commands, __ATOMIC_ACQUIRE);
+    for (int w = 0; w < AUDIO_VOICE_MASK_WORDS; w++) {
+        uint32_t free_bits = ~(claimedBits(w, done) | reserved_voices[w]) & validBits(w);
+        if (free_bits) return w * 32 + lowestBit(free_bits);
+    }
+    return -1;
+}
+
+// Free voice, or else the lowest priority voice at or below priority,
+// the quietest of those and of equally quiet ones the oldest
+int8_t audioMixerAllocVoice(uint8_t priority) {
+    int8_t channel = audioMixerFindFreeVoice();
+    if (channel < 0) {
+        for (int i = 0; i < MAX_CHANNELS; i++) {
+            if (channel_priority[i] > priority || maskBit(reserved_voices, i)) continue;
+            if (channel < 0 ||
+                channel_priority[i] < channel_priority[channel] ||
+                (channel_priority[i] == channel_priority[channel] &&
+                 (channel_amplitude[i] < channel_amplitude[channel] ||
+                  (channel_amplitude[i] == channel_amplitude[channel] &&
+                   (int32_t)(channel_last_start[i] - channel_last_start[channel]) < 0)))) {
+                channel = i;
+            }
+        }
+        if (channel < 0) return -1;
+        steal_count++;
+    }
+    channel_priority[channel] = priority;
+    return channel;
+}
+
+uint32_t audioMixerGetStealCount() {
+    return steal_count;
+}
+
+bool audioMixerIsVoiceActive(uint8_t channel) {
+    if (channel >= MAX_CHANNELS) return false;
+    uint32_t done = __atomic_load_n(&published_commands, __ATOMIC_ACQUIRE);
+    return maskBit(published_busy, channel) || startPending(channel, done);
+}
+
+bool audioMixerIsVoicePlaying(uint8_t channel) {
+    if (channel >= MAX_CHANNELS) return false;
+    return maskBit(published_playing, channel);
+}
+
+uint8_t audioMixerGetActiveCount() {
+    return published_active_count;
+}
+
+uint8_t audioMixerGetPlayingCount() {
+    return published_playing_count;
+}
+
+uint32_t audioMixerGetSampleClock() {
+    return published_sample_clock;
+}
+
+void audioMixerReserveVoice(uint8_t channel, bool reserved) {
+    if (channel >= MAX_CHANNELS) return;
+    if (reserved) reserved_voices[channel >> 5] |= 1u << (channel & 31);
+    else reserved_voices[channel >> 5] &= ~(1u << (channel & 31));
+}
+
+void audioMixerSetMasterGain(uint16_t gain) {
+    // 64 full scale voices times the gain still fit the 32 bit bus
+    master_gain = gain > AUDIO_MASTER_GAIN_MAX ? AUDIO_MASTER_GAIN_MAX : gain;
+}
+
+uint16_t audioMixerGetMasterGain() {
+    return master_gain;
+}
+
+void audioMixerSetBlockHook(AudioBlockHook hook) {
+    block_hook = hook;
+}
+
+// ============================================================================
+// Commands and voice bookkeeping (audio interrupt)
+// ============================================================================
+
+static void setVoiceBusy(AudioVoice* v, bool busy) {
+    uint8_t i = v - voices;
+    if (busy) voice_busy[i >> 5] |= 1u << (i & 31);
+    else voice_busy[i >> 5] &= ~(1u << (i & 31));
+    active_list_dirty = true;
+}
+
+// ============================================================================
+// Envelopes (audio interrupt)
+// ============================================================================
+
+static inline uint32_t msToSamples(uint16_t ms) {
+    return ((uint32_t)ms * sample_rate + 500) / 1000;
+}
+
+// Go to stage, skipping the stages that have no length
+static void envelopeEnter(AudioVoice* v, uint8_t stage) {
+    v->env_stage = stage;
+    switch (stage) {
+        case ENV_ATTACK:
+            if (v->attack_samples == 0) {
+                v->env_level = ENVELOPE_FULL;
+                envelopeEnter(v, ENV_DECAY);
+                return;
+            }
+            v->env_left = v->attack_samples;
+            v->env_rate = (ENVELOPE_FULL - v->env_level) / (int32_t)v->attack_samples;
+            break;
+        case ENV_DECAY:
+            if (v->decay_samples == 0 || v->sustain_level >= ENVELOPE_FULL) {
+                v->env_level = v->sustain_level;
+                envelopeEnter(v, ENV_SUSTAIN);
+                return;
+            }
+            v->env_left = v->decay_samples;
+            v->env_rate = (v->sustain_level - ENVELOPE_FULL) / (int32_t)v->decay_samples;
+            break;
+        case ENV_SUSTAIN:
+            v->env_left = 0;
+            v->env_rate = 0;
+            break;
+        case ENV_RELEASE:
+            if (v->release_samples == 0) {
+                v->env_level = 0;
+                envelopeEnter(v, ENV_DONE);
+                return;
+            }
+            v->env_left = v->release_samples;
+            v->env_rate = -v->env_level / (int32_t)v->release_samples;
+            break;
+        case ENV_DONE:
+            v->env_level = 0;
+            v->env_left = 0;
+            v->env_rate = 0;
+            break;
+    }
+}
+
+// Level after samples more, stage ends land on their exact target level
+static void envelopeAdvance(AudioVoice* v, uint32_t samples) {
+    while (samples > 0 && v->env_left > 0) {
+        uint32_t k = samples < v->env_left ? samples : v->env_left;
+        v->env_level += v->env_rate * (int32_t)k;
+        v->env_left -= k;
+        samples -= k;
+        if (v->env_left == 0) {
+            switch (v->env_stage) {
+                case ENV_ATTACK:
+                    v->env_level = ENVELOPE_FULL;
+                    envelopeEnter(v, ENV_DECAY);
+                    break;
+                case ENV_DECAY:
+                    v->env_level = v->sustain_level;
+                    envelopeEnter(v, ENV_SUSTAIN);
+                    break;
+                case ENV_RELEASE:
+                    envelopeEnter(v, ENV_DONE);
+                    break;
+            }
+        }
+    }
+}
+
+static inline void setVoicePan(AudioVoice* v, int8_t pan) {
+    int32_t index = (pan < -127 ? -127 : pan) + 127;
+    v->pan_left = pan_table[AUDIO_PAN_STEPS - index];
+    v->pan_right = pan_table[index];
+}
+
+// Envelope gain (Q24 level * amplitude, kept >> 8) on one side of the pan
+static inline int32_t panGain(int32_t gain, int16_t pan) {
+    return (int32_t)(((int64_t)gain * pan) >> 14);
+}
+
+static void startVoice(AudioVoice* v, const AudioVoiceParams* params, uint32_t start_sample, bool scheduled) {
+    const AudioEnvelope* env = &params->envelope;
+    v->phase_increment = params->phase_increment;
+    v->amplitude = params->amplitude;
+    v->duration_samples = params->duration_samples;
+    v->table = wavetables[params->waveform < WAVE_COUNT ? params->waveform : (uint8_t)WAVE_SINE];
+    v->sample_data = NULL;
+    setVoicePan(v, params->pan);
+    v->start_sample = start_sample;
+    v->phase = 0;
+    v->samples_played = 0;
+
+    v->attack_samples = msToSamples(env->attack_ms);
+    v->decay_samples = msToSamples(env->decay_ms);
+    v->release_samples = msToSamples(env->release_ms);
+    v->sustain_level = (int32_t)(((uint32_t)env->sustain << 24) / 255);
+    if (v->duration_samples > 0) {
+        // The release ends with the duration, short notes release over their second half
+        if (v->release_samples > v->duration_samples / 2 && v->release_samples + v->attack_samples > v->duration_samples) {
+            v->release_samples = v->duration_samples / 2;
+        }
+        v->release_at = v->duration_samples - v->release_samples;
+    } else {
+        v->release_at = 0xFFFFFFFF;
+    }
+    v->env_level = 0;
+    envelopeEnter(v, ENV_ATTACK);
+
+    v->active = !scheduled;
+    v->scheduled = scheduled;
+    setVoiceBusy(v, true);
+}
+
+// Step through the clip per output sample for pitch, both with a 16 bit fraction
+static inline uint32_t sampleStep(uint16_t rate, uint32_t pitch) {
+    return (uint32_t)(((uint64_t)rate * pitch) / sample_rate);
+}
+
+static void startSample(AudioVoice* v, const AudioSample* sample, uint32_t pitch) {
+    v->sample_data = sample->data;
+    v->sample_length = sample->length;
+    v->sample_rate = sample->sample_rate;
+    v->sample_next = 0;
+    v->adpcm.predictor = sample->predictor;
+    v->adpcm.step_index = sample->step_index;
+    v->s0 = 0;
+    v->s1 = 0;
+    v->phase = 0;
+    v->phase_increment = sampleStep(sample->sample_rate, pitch);
+}
+
+// Sample clock of the next track event
+static inline uint32_t trackEventSample(const AudioVoice* v) {
+    uint32_t tick = v->track_next[0] | (v->track_next[1] << 8);
+    return v->track_start + (uint32_t)(((uint64_t)tick * TONE_SAMPLE_RATE + TONE_TICKS_PER_SECOND / 2) / TONE_TICKS_PER_SECOND);
+}
+
+// Loads the next track event into the voice, it starts at start_sample
+static void trackStartEvent(AudioVoice* v, uint32_t start_sample) {
+    const uint8_t* e = v->track_next;
+    AudioVoiceParams params;
+    params.phase_increment = toneNoteIncrement(e[2]);
+    params.duration_samples = toneTicksToSamples(e[3]);
+    params.amplitude = (uint16_t)((v->track_amplitude * e[5] + 127) / 255);
+    params.waveform = e[4] >> 4;
+    params.envelope = v->track_envelopes[e[4] & 0x0F];
+    params.pan = v->track_pan;
+    v->track_next += AUDIO_TRACK_EVENT_BYTES;
+    v->track_left--;
+    startVoice(v, &params, start_sample, true);
+}
+
+static void stopVoice(AudioVoice* v) {
+    v->track_left = 0;
+    // Don't instantly stop - release from the current level
+    if (v->active) {
+        if (v->env_stage < ENV_RELEASE) {
+            if (v->release_samples < ENVELOPE_MIN_RELEASE) v->release_samples = ENVELOPE_MIN_RELEASE;
+            envelopeEnter(v, ENV_RELEASE);
+            v->duration_samples = v->samples_played + v->release_samples;
+            v->release_at = v->samples_played;
+        }
+    } else {
+        // Not active yet (or between two track notes), just cancel it
+        v->scheduled = false;
+        setVoiceBusy(v, false);
+    }
+}
+
+static void applyCommand(const AudioCommand* cmd) {
+    AudioVoice* v = &voices[cmd->channel];
+    switch (cmd->type) {
+        case AUDIO_CMD_START:
+            // start_sample holds the delay, counted from the block that picks the command up
+            v->track_left = 0;
+            startVoice(v, &cmd->params, sample_clock + cmd->start_sample, cmd->start_sample != 0);
+            break;
+        case AUDIO_CMD_SCHEDULE:
+            v->track_left = 0;
+            startVoice(v, &cmd->params, cmd->start_sample, true);
+            break;
+        case AUDIO_CMD_TRACK:
+            // The notes are started by the render loop when their sample comes up
+            v->active = false;
+            v->scheduled = false;
+            v->track_next = cmd->track_events;
+            v->track_envelopes = cmd->track_envelopes;
+            v->track_left = cmd->track_count;
+            v->track_amplitude = cmd->params.amplitude;
+            v->track_pan = cmd->params.pan;
+            v->track_start = sample_clock + cmd->start_sample;
+            setVoiceBusy(v, true);
+            break;
+        case AUDIO_CMD_SAMPLE:
+            v->track_left = 0;
+            startVoice(v, &cmd->params, sample_clock + cmd->start_sample, cmd->start_sample != 0);
+            startSample(v, cmd->sample, cmd->params.phase_increment);
+            break;
+        case AUDIO_CMD_SET_VOLUME:
+            v->amplitude = cmd->params.amplitude;
+            v->track_amplitude = cmd->params.amplitude;
+            break;
+        case AUDIO_CMD_SET_PAN:
+            setVoicePan(v, cmd->params.pan);
+            v->track_pan = cmd->params.pan;
+            break;
+        case AUDIO_CMD_SET_PITCH:
+            if (v->sample_data) v->phase_increment = sampleStep(v->sample_rate, cmd->params.phase_increment);
+            break;
+        case AUDIO_CMD_STOP:
+            stopVoice(v);
+            break;
+        case AUDIO_CMD_CANCEL:
+            v->track_left = 0;
+            v->active = false;
+            v->scheduled = false;
+            setVoiceBusy(v, false);
+            break;
+        case AUDIO_CMD_STOP_ALL:
+            // Let playing channels fade out naturally. Walks the live busy mask, the
+            // active list is only rebuilt after the drain and misses voices started
+            // by earlier commands in it
+            for (int w = 0; w < AUDIO_VOICE_MASK_WORDS; w++) {
+                uint32_t bits = voice_busy[w];
+                while (bits) {
+                    stopVoice(&voices[w * 32 + lowestBit(bits)]);
+                    bits &= bits - 1;
+                }
+            }
+            break;
+    }
+}
+
+// ============================================================================
+// Block hook voice access (audio interrupt)
+// ============================================================================
+
+void audioMixerHookStartVoice(uint8_t channel, const AudioVoiceParams* params, uint32_t offset) {
+    if (channel >= MAX_CHANNELS) return;
+    AudioVoice* v = &voices[channel];
+    v->track_left = 0;
+    startVoice(v, params, sample_clock + offset, true);
+}
+
+void audioMixerHookSetVoicePitch(uint8_t channel, uint32_t phase_increment) {
+    if (channel >= MAX_CHANNELS) return;
+    voices[channel].phase_increment = phase_increment;
+}
+
+void audioMixerHookSetVoiceVolume(uint8_t channel, uint16_t amplitude) {
+    if (channel >= MAX_CHANNELS) return;
+    voices[channel].amplitude = amplitude;
+}
+
+void audioMixerHookStopVoice(uint8_t channel) {
+    if (channel >= MAX_CHANNELS) return;
+    stopVoice(&voices[channel]);
+}
+
+static void resetTimingStats() {
+    latency_count = 0;
+    latency_min_frames = 0xFFFFFFFFu;
+    latency_max_frames = 0;
+    latency_last_frames = 0;
+    latency_sum_frames = 0;
+    block_count = 0;
+    block_cycles_min = 0xFFFFFFFFu;
+    block_cycles_max = 0;
+    block_cycles_sum = 0;
+    for (int i = 0; i < AUDIO_FILL_BUCKETS; i++) fill_histogram[i] = 0;
+    timing_reset = false;
+}
+
+static void recordLatency(uint32_t frames) {
+    frames += output_latency_frames;
+    latency_count = latency_count + 1;
+    latency_sum_frames = latency_sum_frames + frames;
+    latency_last_frames = frames;
+    if (frames < latency_min_frames) latency_min_frames = frames;
+    if (frames > latency_max_frames) latency_max_frames = frames;
+}
+
+static void recordBlockCycles(uint32_t cycles) {
+    block_count = block_count + 1;
+    block_cycles_sum = block_cycles_sum + cycles;
+    if (cycles < block_cycles_min) block_cycles_min = cycles;
+    if (cycles > block_cycles_max) block_cycles_max = cycles;
+}
+
+static void drainCommands() {
+    uint32_t head = __atomic_load_n(&command_head, __ATOMIC_ACQUIRE);
+    uint32_t tail = command_tail;
+    while (tail != head) {
+        const AudioCommand* cmd = &command_queue[tail & (AUDIO_COMMAND_QUEUE_SIZE - 1)];
+        // Starts without a delay play from this block, the delay is asked for so it isn't latency
+        if (cmd->type == AUDIO_CMD_START || cmd->type == AUDIO_CMD_TRACK || cmd->type == AUDIO_CMD_SAMPLE) {
+            recordLatency(sample_clock - cmd->trigger_frame);
+        }
+        applyCommand(cmd);
+        tail++;
+    }
+    __atomic_store_n(&command_tail, tail, __ATOMIC_RELEASE);
+}
+
+static void rebuildActiveChannelList() {
+    active_channel_count = 0;
+    for (int w = 0; w < AUDIO_VOICE_MASK_WORDS; w++) {
+        uint32_t bits = voice_busy[w];
+        while (bits) {
+            active_channel_indices[active_channel_count++] = w * 32 + lowestBit(bits);
+            bits &= bits - 1;
+        }
+    }
+    active_list_dirty = false;
+}
+
+static void publishVoiceState() {
+    uint32_t playing[AUDIO_VOICE_MASK_WORDS] = { 0 };
+    uint8_t playing_count = 0;
+    for (uint8_t idx = 0; idx < active_channel_count; idx++) {
+        uint8_t i = active_channel_indices[idx];
+        if (voices[i].active) {
+            playing[i >> 5] |= 1u << (i & 31);
+            playing_count++;
+        }
+    }
+    for (int w = 0; w < AUDIO_VOICE_MASK_WORDS; w++) {
+        published_busy[w] = voice_busy[w];
+        published_playing[w] = playing[w];
+    }
+    published_active_count = active_channel_count;
+    published_playing_count = playing_count;
+    published_sample_clock = sample_clock;
+    __atomic_store_n(&published_commands, command_tail, __ATOMIC_RELEASE);
+}
+
+// ============================================================================
+// Rendering (audio interrupt)
+// ============================================================================
+
+// Mixes frames [from, to) of the block for one voice, mix is interleaved left / right
+static void renderVoice(AudioVoice* v, int32_t* mix, uint32_t from, uint32_t to) {
+    // Scheduled voices start at their exact sample inside the block
+    uint32_t first = from;
+    if (v->scheduled) {
+        int32_t offset = (int32_t)(v->start_sample - sample_clock);
+        if (offset >= (int32_t)to) return;
+        if (offset > (int32_t)from) first = offset;
+        v->scheduled = false;
+        v->active = true;
+    }
+    if (!v->active) return;
+
+    uint32_t n = to - first;
+    uint32_t played = v->samples_played;
+    bool ends = false;
+    if (v->duration_samples > 0) {
+        uint32_t remaining = (v->duration_samples > played) ? v->duration_samples - played : 0;
+        if (remaining <= n) {
+            n = remaining;
+            ends = true;
+        }
+    }
+
+    // Envelope at the start and the end of this range, the release may start inside it
+    int32_t level_start = v->env_level;
+    if (v->env_stage < ENV_RELEASE && played + n >= v->release_at) {
+        uint32_t before = v->release_at > played ? v->release_at - played : 0;
+        envelopeAdvance(v, before);
+        envelopeEnter(v, ENV_RELEASE);
+        envelopeAdvance(v, n - before);
+    } else {
+        envelopeAdvance(v, n);
+    }
+    if (v->env_stage == ENV_DONE) ends = true;
+
+    // Work on local copies, written back once at the end of the range
+    uint32_t phase = v->phase;
+    uint32_t phase_increment = (uint32_t)(((uint64_t)v->phase_increment * block_rate_correction) >> 16);
+    if (v->sample_data) {
+        // Clip: decode up to the sample after the position, interpolate between the two
+        const uint8_t* data = v->sample_data;
+        uint32_t length = v->sample_length;
+        uint32_t next = v->sample_next;
+        AdpcmState adpcm = v->adpcm;
+        int32_t s0 = v->s0;
+        int32_t s1 = v->s1;
+        int32_t gain = (level_start >> 8) * v->amplitude;
+        int32_t gain_end = (v->env_level >> 8) * v->amplitude;
+        int32_t gain_left = panGain(gain, v->pan_left);
+        int32_t gain_right = panGain(gain, v->pan_right);
+        int32_t step_left = n ? (panGain(gain_end, v->pan_left) - gain_left) / (int32_t)n : 0;
+        int32_t step_right = n ? (panGain(gain_end, v->pan_right) - gain_right) / (int32_t)n : 0;
+        for (uint32_t i = first; i < first + n; i++) {
+            uint32_t index = phase >> 16;
+            if (index + 1 >= length) {
+                ends = true;
+                break;
+            }
+            while (next < index + 2) {
+                s0 = s1;
+                s1 = adpcmDecodeSample(&adpcm, adpcmNibble(data, next));
+                next++;
+            }
+            int32_t sample = s0 + (((s1 - s0) * (int32_t)((phase >> 1) & 0x7FFF)) >> 15);
+
+            mix[2 * i] += (sample * (gain_left >> 9)) >> 15;
+            mix[2 * i + 1] += (sample * (gain_right >> 9)) >> 15;
+            gain_left += step_left;
+            gain_right += step_right;
+            phase += phase_increment;
+        }
+        v->sample_next = next;
+        v->adpcm = adpcm;
+        v->s0 = s0;
+        v->s1 = s1;
+    } else if (v->amplitude == 0 || n == 0) {
+        // Skip if volume is zero, only advance
+        phase += phase_increment * n;
+    } else {
+        const int16_t* table = v->table;
+        // gain is level * amplitude (Q24 * 8 bit, kept >> 8) times the pan of each side,
+        // ramped linearly over the range
+        int32_t gain = (level_start >> 8) * v->amplitude;
+        int32_t gain_end = (v->env_level >> 8) * v->amplitude;
+        int32_t gain_left = panGain(gain, v->pan_left);
+        int32_t gain_right = panGain(gain, v->pan_right);
+        int32_t step_left = (panGain(gain_end, v->pan_left) - gain_left) / (int32_t)n;
+        int32_t step_right = (panGain(gain_end, v->pan_right) - gain_right) / (int32_t)n;
+        for (uint32_t i = first; i < first + n; i++) {
+            // Linear interpolation between two table entries, 15 bit fraction
+            uint32_t index = phase >> WAVETABLE_SHIFT;
+            int32_t frac = (phase >> (WAVETABLE_SHIFT - 15)) & 0x7FFF;
+            int32_t a = table[index];
+            int32_t sample = a + (((table[index + 1] - a) * frac) >> 15);
+
+            mix[2 * i] += (sample * (gain_left >> 9)) >> 15;
+            mix[2 * i + 1] += (sample * (gain_right >> 9)) >> 15;
+            gain_left += step_left;
+            gain_right += step_right;
+            phase += phase_increment;
+        }
+    }
+
+    v->phase = phase;
+    v->samples_played = played + n;
+    if (ends) {
+        v->active = false;
+        // a track keeps its voice until the last note is done
+        if (v->track_left == 0) setVoiceBusy(v, false);
+    }
+}
+
+// Output of the mix bus for one channel: master gain, soft clip, dither
+static inline int32_t mixBusSample(int32_t mixed, int32_t gain, uint32_t* dither_state) {
+    // Master gain folded into one multiply, then the soft clip table above the knee
+    int32_t sample = (mixed * gain) >> 8;
+    if (sample > AUDIO_CLIP_KNEE || sample < -AUDIO_CLIP_KNEE) {
+        sample = softClip(sample);
+    }
+
+    // Dithering, independent on both channels
+    uint32_t d = *dither_state;
+    d ^= d << 13;
+    d ^= d >> 17;
+    d ^= d << 5;
+    *dither_state = d;
+    sample += (int32_t)(d & 0x03) - 2;
+
+    // The table tops out below full scale, only the dither can cross it
+    if (sample > 32767) sample = 32767;
+    if (sample < -32768) sample = -32768;
+    return sample;
+}
+
+static void renderChunk(uint32_t* out, uint32_t frames) {
+    uint32_t start_cycles = AUDIO_CYCLES();
+    if (timing_reset) resetTimingStats();
+    drainCommands();
+    block_rate_correction = rate_correction;
+    AudioBlockHook hook = block_hook;
+    if (hook) hook(sample_clock, frames);
+    if (active_list_dirty) rebuildActiveChannelList();
+
+    int32_t mix[AUDIO_BLOCK_FRAMES * 2];
+    memset(mix, 0, frames * 2 * sizeof(int32_t));
+
+    for (uint8_t idx = 0; idx < active_channel_count; idx++) {
+        AudioVoice* v = &voices[active_channel_indices[idx]];
+
+        // Track notes due in this block take over the voice at their sample,
+        // the note before plays up to there
+        uint32_t pos = 0;
+        while (v->track_left > 0) {
+            int32_t at = (int32_t)(trackEventSample(v) - sample_clock);
+            if (at >= (int32_t)frames) break;
+            if (at < (int32_t)pos) at = pos;
+            renderVoice(v, mix, pos, at);
+            trackStartEvent(v, sample_clock + at);
+            pos = at;
+        }
+        renderVoice(v, mix, pos, frames);
+    }
+    if (active_list_dirty) rebuildActiveChannelList();
+    sample_clock += frames;
+    publishVoiceState();
+
+    int32_t gain = master_gain;
+    for (uint32_t i = 0; i < frames; i++) {
+        int32_t left = mixBusSample(mix[2 * i], gain, &dither_left);
+        int32_t right = mixBusSample(mix[2 * i + 1], gain, &dither_right);
+        out[i] = (uint16_t)left | ((uint32_t)(uint16_t)right << 16);
+    }
+    recordBlockCycles(AUDIO_CYCLES() - start_cycles);
+}
+
+// Render interleaved stereo frames
+void audioMixerRender(int16_t* stereo, uint32_t frames) {
+    while (frames > 0) {
+        uint32_t chunk = frames > AUDIO_BLOCK_FRAMES ? AUDIO_BLOCK_FRAMES : frames;
+        renderChunk((uint32_t*)stereo, chunk);
+        pulled_frames += chunk;   // the caller is the output
+        stereo += chunk * 2;
+        frames -= chunk;
+    }
+}
+
+// Render every free block of the ring
+void audioMixerFillRing() {
+    while ((uint8_t)(ring_write - ring_read) < AUDIO_RING_BLOCKS) {
+        renderChunk(ring[ring_write % AUDIO_RING_BLOCKS], AUDIO_BLOCK_FRAMES);
+        ring_write++;
+    }
+}
+
+const int16_t* audioMixerPeekBlock() {
+    if (ring_read == ring_write) return NULL;
+    return (const int16_t*)ring[ring_read % AUDIO_RING_BLOCKS];
+}
+
+void audioMixerReleaseBlock() {
+    if (ring_read != ring_write) ring_read++;
+}
+
+uint8_t audioMixerReadyBlocks() {
+    return (uint8_t)(ring_write - ring_read);
+}
+
+void audioMixerPull(AudioBlockSink sink) {
+    const int16_t* block = audioMixerPeekBlock();
+    if (!block) {
+        audioMixerFillRing();
+        block = audioMixerPeekBlock();
+    }
+    sink(block, AUDIO_BLOCK_BYTES);
+    audioMixerReleaseBlock();
+    pulled_frames += AUDIO_BLOCK_FRAMES;
+    // Render the replacement now, the next pull only has to hand it over
+    audioMixerFillRing();
+}
+
+// ============================================================================
+// Rate lock
+// ============================================================================
+
+void audioMixerMeasureRate(uint32_t now_us) {
+    uint32_t frames = pulled_frames;
+    if (!rate_started) {
+        rate_started = true;
+        rate_window_us = now_us;
+        rate_window_frames = frames;
+        return;
+    }
+    uint32_t elapsed = now_us - rate_window_us;  // wraps correctly
+    if (elapsed < AUDIO_RATE_WINDOW_US) return;
+    uint32_t window_frames = frames - rate_window_frames;
+    rate_window_us = now_us;
+    rate_window_frames = frames;
+    if (window_frames == 0) return;
+
+    uint32_t rate_q8 = (uint32_t)(((uint64_t)window_frames * 1000000 * 256 + elapsed / 2) / elapsed);
+    uint32_t correction = (uint32_t)(((uint64_t)sample_rate << 24) / rate_q8);
+    // a window far off is a stall (debugger, flash write), not the clock
+    if (correction < AUDIO_RATE_CORRECTION_MIN || correction > AUDIO_RATE_CORRECTION_MAX) return;
+
+    // the first window is taken as is, later ones only nudge it against timer jitter
+    if (rate_windows++ == 0) {
+        measured_rate_q8 = rate_q8;
+        rate_correction = correction;
+    } else {
+        measured_rate_q8 = measured_rate_q8 + ((int32_t)(rate_q8 - measured_rate_q8) >> 2);
+        rate_correction = rate_correction + ((int32_t)(correction - rate_correction) >> 2);
+    }
+}
+
+uint32_t audioMixerGetMeasuredRate() {
+    return (measured_rate_q8 + 128) >> 8;
+}
+
+uint32_t audioMixerGetRateCorrection() {
+    return rate_correction;
+}
+
+// ============================================================================
+// Timing stats
+// ============================================================================
+
+void audioMixerSetOutputLatency(uint32_t frames) {
+    output_latency_frames = frames;
+}
+
+void audioMixerRecordOutputFill(uint32_t queued, uint32_t capacity) {
+    if (capacity == 0) return;
+    if (queued > capacity) queued = capacity;
+    uint32_t bucket = (uint32_t)(((uint64_t)queued * AUDIO_FILL_BUCKETS) / (capacity + 1));
+    fill_histogram[bucket] = fill_histogram[bucket] + 1;
+}
+
+static uint32_t framesToMicros(uint64_t frames) {
+    // the measured rate once there is one, the output plays at that
+    uint32_t rate = audioMixerGetMeasuredRate();
+    if (rate == 0) rate = sample_rate;
+    return (uint32_t)((frames * 1000000 + rate / 2) / rate);
+}
+
+void audioMixerGetTimingStats(AudioTimingStats* stats) {
+    uint32_t count = latency_count;
+    stats->latency_count = count;
+    stats->latency_min_us = count ? framesToMicros(latency_min_frames) : 0;
+    stats->latency_avg_us = count ? framesToMicros(latency_sum_frames / count) : 0;
+    stats->latency_max_us = framesToMicros(latency_max_frames);
+    stats->latency_last_us = framesToMicros(latency_last_frames);
+    uint32_t blocks = block_count;
+    stats->block_count = blocks;
+    stats->block_cycles_min = blocks ? block_cycles_min : 0;
+    stats->block_cycles_avg = blocks ? (uint32_t)(block_cycles_sum / blocks) : 0;
+    stats->block_cycles_max = block_cycles_max;
+    for (int i = 0; i < AUDIO_FILL_BUCKETS; i++) stats->fill_histogram[i] = fill_histogram[i];
+}
+
+void audioMixerResetTimingStats() {
+    timing_reset = true;
+}
+
+// ============================================================================
+// Software clock
+// ============================================================================
+
+void audioSoftClockStart(uint32_t now_us) {
+    soft_clock_last_us = now_us;
+    soft_clock_frames_x1M = 0;
+}
+
+uint32_t audioSoftClockAdvance(uint32_t now_us, AudioBlockSink sink) {
+    uint32_t elapsed = now_us - soft_clock_last_us;  // wraps correctly
+    soft_clock_last_us = now_us;
+    soft_clock_frames_x1M += (uint64_t)elapsed * sample_rate;
+
+    const uint64_t block_x1M = (uint64_t)AUDIO_BLOCK_FRAMES * 1000000;
+    uint32_t pulled = 0;
+    while (soft_clock_frames_x1M >= block_x1M) {
+        soft_clock_frames_x1M -= block_x1M;
+        audioMixerPull(sink);
+        pulled++;
+    }
+    return pulled;
+}
@@ -0,0 +1,216 @@
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <stdint.h>
+
+// Configuration
+#ifndef MAX_CHANNELS
+#define MAX_CHANNELS 64
+#endif
+#ifndef AUDIO_BLOCK_FRAMES
+#define AUDIO_BLOCK_FRAMES 128     // stereo frames rendered per block
+#endif
+#ifndef AUDIO_RING_BLOCKS
+#define AUDIO_RING_BLOCKS 4        // blocks rendered ahead of the output
+#endif
+#ifndef AUDIO_COMMAND_QUEUE_SIZE
+#define AUDIO_COMMAND_QUEUE_SIZE 64  // power of 2
+#endif
+// Voice priorities for audioMixerAllocVoice, a full mixer steals from the lowest
+#define AUDIO_PRIORITY_LOW 0
+#define AUDIO_PRIORITY_NORMAL 128
+#define AUDIO_PRIORITY_HIGH 255
+#ifndef WAVETABLE_BITS
+#define WAVETABLE_BITS 10           // 1024 entry tables
+#endif
+#ifndef AUDIO_MIX_HEADROOM_BITS
+#define AUDIO_MIX_HEADROOM_BITS 2   // the mix bus soft clips up to 4x full scale
+#endif
+#ifndef AUDIO_MASTER_GAIN_DEFAULT
+#define AUDIO_MASTER_GAIN_DEFAULT 192  // 256 is unity
+#endif
+#define WAVETABLE_SIZE (1 << WAVETABLE_BITS)
+#define WAVETABLE_SHIFT (32 - WAVETABLE_BITS)
+#define AUDIO_BLOCK_BYTES (AUDIO_BLOCK_FRAMES * 2 * sizeof(int16_t))
+#define AUDIO_VOICE_MASK_WORDS ((MAX_CHANNELS + 31) / 32)
+#define AUDIO_RATE_CORRECTION_UNITY 65536
+
+// Hardware independent mixer core of i2stones, builds on the host as well.
+// Voices are mixed a block at a time into a ring of interleaved 16 bit stereo
+// blocks, every voice placed in the stereo field with a constant power pan.
+// The output pulls: every time it finished playing a buffer it asks for
+// exactly one block, so the output clock paces the mixer and nothing can drift.
+// Typical usage (I2S transmit callback):
+//   void onTransmit() {
+//     while (i2s.availableForWrite() >= AUDIO_BLOCK_BYTES)
+//       audioMixerPull(writeToI2S);
+//   }
+// Without an output device the software clock pulls blocks from elapsed time:
+//   audioSoftClockStart(micros());
+//   audioSoftClockAdvance(micros(), writeToFile);   // call regularly
+//
+// Threads: the voice functions are called from one (game) thread and only put a
+// command in a single producer / single consumer queue. The mixer owns the voices
+// and applies the queued commands at the start of every block it renders.
+// The query functions see the state published after the last block plus the
+// commands still waiting, so a channel that was just started is never handed out twice.
+//
+// Timing is in output samples. A started voice begins at its delay counted from the
+// first sample of the block that picks the command up, commands queued between
+// audioMixerBeginBatch / audioMixerEndBatch are picked up by the same block, so
+// the notes of a jingle keep their spacing to the sample whatever the game is doing.
+
+// Waveforms, 16 bit tables read with linear interpolation.
+// Noise is a table of random values too, its pitch sets how bright it sounds:
+// low notes (tens of Hz) give hiss, higher ones a rough buzz.
+enum AudioWaveform {
+    WAVE_SINE,
+    WAVE_SQUARE,
+    WAVE_TRIANGLE,
+    WAVE_SAW,
+    WAVE_NOISE,
+    WAVE_COUNT
+};
+
+// ADSR envelope. A voice with a duration starts its release so it ends at the
+// duration, endless voices release when stopped (at least 64 samples).
+struct AudioEnvelope {
+    uint16_t attack_ms;
+    uint16_t decay_ms;
+    uint8_t sustain;            // 0-255 level held after the decay
+    uint16_t release_ms;
+};
+
+// Short fade in and out against clicks, about what every tone had before envelopes
+#define AUDIO_ENVELOPE_DEFAULT { 1, 0, 255, 2 }
+
+struct AudioVoiceParams {
+    uint32_t phase_increment;   // 2^32 is one cycle per sample
+    uint32_t duration_samples;  // 0 plays until stopped
+    uint16_t amplitude;         // 0-255
+    uint8_t waveform;           // AudioWaveform
+    AudioEnvelope envelope;
+    int8_t pan;                 // -127 left, 0 center, 127 right
+};
+
+// Tracks: a voice plays a list of notes (sound bank data, see soundbank.h) that the
+// mixer starts itself when their sample comes up, so a whole jingle is one command
+// and one voice. Events are AUDIO_TRACK_EVENT_BYTES each, sorted by start:
+//   start tick (16 bit little endian, from the track start), MIDI note, duration ticks,
+//   waveform << 4 | envelope index, level 0-255 (scales the track amplitude)
+// Ticks are TONE_TICKS_PER_SECOND (notetables.h), a note ends at the latest where the next starts.
+#define AUDIO_TRACK_EVENT_BYTES 6
+
+// Block hook: runs in the audio interrupt at the start of every block, after the
+// queued commands and before the voices are mixed, so it can drive voices for a
+// player (music) with sample exact starts and without going through the queue.
+// It may only touch voices with the audioMixerHook functions, and only voices the
+// game thread reserved for it, so sound effects never wait for it or lose a voice.
+typedef void (*AudioBlockHook)(uint32_t block_start_sample, uint32_t frames);
+
+// Sample clip, IMA ADPCM (adpcm.h) in flash, made by tools/samples/mksamples.py.
+// Played back with linear interpolation at any pitch, decoded as the voice reaches
+// new samples so nothing is unpacked into RAM.
+struct AudioSample {
+    const uint8_t* data;        // 4 bits per sample, low nibble first
+    uint16_t length;            // samples
+    uint16_t sample_rate;       // rate it was recorded at
+    int16_t predictor;          // decoder state before the first sample
+    uint8_t step_index;
+};
+
+// Sample pitch, 16 bit fraction: AUDIO_PITCH_NORMAL plays at the recorded rate
+#define AUDIO_PITCH_NORMAL 65536
+
+// Receives one finished block of AUDIO_BLOCK_FRAMES interleaved stereo frames
+typedef void (*AudioBlockSink)(const int16_t* block, uint32_t bytes);
+
+void audioMixerInit(uint32_t sample_rate);   // call while no output is pulling
+uint32_t audioMixerGetSampleRate();
+
+// Voices, return false when the command queue is full
+bool audioMixerStartVoice(uint8_t channel, const AudioVoiceParams* params, uint32_t delay_samples);
+bool audioMixerScheduleVoice(uint8_t channel, const AudioVoiceParams* params, uint32_t start_sample);  // absolute sample clock
+bool audioMixerStartTrack(uint8_t channel, const uint8_t* events, uint8_t event_count,
+                          const AudioEnvelope* envelopes, uint16_t amplitude, int8_t pan, uint32_t delay_samples);
+bool audioMixerStartSample(uint8_t channel, const AudioSample* sample, uint32_t pitch,
+                           uint16_t amplitude, int8_t pan, uint32_t delay_samples);
+bool audioMixerSetVoiceVolume(uint8_t channel, uint16_t amplitude);
+bool audioMixerSetSamplePitch(uint8_t channel, uint32_t pitch);   // sample voices only
+bool audioMixerSetVoicePan(uint8_t channel, int8_t pan);
+bool audioMixerStopVoice(uint8_t channel);    // short fade out
+bool audioMixerCancelVoice(uint8_t channel);  // immediate
+bool audioMixerStopAll();
+void audioMixerBeginBatch();   // nests, the mixer sees the commands at the outermost end
+void audioMixerEndBatch();
+int8_t audioMixerFindFreeVoice();                 // -1 when all voices are taken
+int8_t audioMixerAllocVoice(uint8_t priority);    // steals when full, -1 if all voices rank higher
+uint32_t audioMixerGetStealCount();
+bool audioMixerIsVoiceActive(uint8_t channel);    // playing or scheduled
+bool audioMixerIsVoicePlaying(uint8_t channel);
+uint8_t audioMixerGetActiveCount();               // playing or scheduled after the last block
+uint8_t audioMixerGetPlayingCount();
+uint32_t audioMixerGetSampleClock();              // frames rendered so far, schedule against this
+void audioMixerReserveVoice(uint8_t channel, bool reserved);   // keeps it from FindFree / Alloc
+// Master gain on the sum of all voices, 256 is unity (at most 512), louder mixes soft clip
+void audioMixerSetMasterGain(uint16_t gain);
+uint16_t audioMixerGetMasterGain();
+
+// Block hook, game thread sets it, NULL removes it
+void audioMixerSetBlockHook(AudioBlockHook hook);
+// Called from the hook only, offset is the sample inside the block
+void audioMixerHookStartVoice(uint8_t channel, const AudioVoiceParams* params, uint32_t offset);
+void audioMixerHookSetVoicePitch(uint8_t channel, uint32_t phase_increment);
+void audioMixerHookSetVoiceVolume(uint8_t channel, uint16_t amplitude);
+void audioMixerHookStopVoice(uint8_t channel);
+
+// Rendering (output side)
+void audioMixerRender(int16_t* stereo, uint32_t frames);   // stereo 4 byte aligned
+void audioMixerFillRing();
+const int16_t* audioMixerPeekBlock();  // NULL when no block is ready
+void audioMixerReleaseBlock();
+uint8_t audioMixerReadyBlocks();
+void audioMixerPull(AudioBlockSink sink);  // hands exactly one block to sink
+
+// Rate lock: an output whose clock is not exactly the sample rate (I2S dividers
+// give 43478 Hz for 44100) calls this with the system timer after it pulled, the
+// mixer measures the real rate over one second windows and scales every phase
+// increment by nominal / measured, so tones, music and samples keep their pitch.
+//   void onTransmit() { ...pull...; audioMixerMeasureRate(micros()); }
+void audioMixerMeasureRate(uint32_t now_us);
+uint32_t audioMixerGetMeasuredRate();     // Hz, 0 before the first window
+uint32_t audioMixerGetRateCorrection();   // AUDIO_RATE_CORRECTION_UNITY until measured
+
+// Timing instrumentation, gathered in the audio interrupt.
+// Latency runs from the call that starts a voice (tone, note, sound bank track,
+// sample; scheduled voices and the requested delay don't count) to its first sample
+// leaving the DAC: the blocks rendered ahead in the ring plus the frames the output
+// queues, which it tells the mixer with audioMixerSetOutputLatency. It is counted in
+// pulled blocks, so it is exact to a block, not to where the DAC is inside one.
+// Output fill is sampled by the output each time it is about to refill, the
+// histogram shows how far it drains over time, the low buckets are near underruns.
+//   audioMixerRecordOutputFill(queued_bytes, buffer_bytes);   // in the output callback
+//   AudioTimingStats stats; audioMixerGetTimingStats(&stats);
+#define AUDIO_FILL_BUCKETS 8
+struct AudioTimingStats {
+    uint32_t latency_count;     // voice starts measured
+    uint32_t latency_min_us;
+    uint32_t latency_avg_us;
+    uint32_t latency_max_us;
+    uint32_t latency_last_us;
+    uint32_t block_count;       // blocks rendered
+    uint32_t block_cycles_min;  // cycles per block (nanoseconds in host builds)
+    uint32_t block_cycles_avg;
+    uint32_t block_cycles_max;
+    uint32_t fill_histogram[AUDIO_FILL_BUCKETS];   // bucket i: fill in [i, i + 1) / AUDIO_FILL_BUCKETS, full in the last
+};
+
+void audioMixerSetOutputLatency(uint32_t frames);   // frames queued between a pull and the DAC
+void audioMixerRecordOutputFill(uint32_t queued, uint32_t capacity);
+void audioMixerGetTimingStats(AudioTimingStats* stats);
+void audioMixerResetTimingStats();   // takes effect at the next block
+
+// Software clock, consumes blocks at the sample rate from elapsed microseconds
+void audioSoftClockStart(uint32_t now_us);
+uint32_t audioSoftClockAdvance(uint32_t now_us, AudioBlockSink sink);  // returns blocks pulled
+#endif
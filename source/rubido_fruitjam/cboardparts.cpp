@@ -57,4 +57,20 @@ void CBoardParts_Draw(CBoardParts* BoardParts)
 	int Teller;
 	for (Teller=0;Teller<BoardParts->ItemCount;Teller++)
 		CPeg_Draw(BoardParts->Items[Teller]);
+}
+
+// draw the boardparts whose tile overlaps the area
+void CBoardParts_DrawArea(CBoardParts* BoardParts, const FbRect* Area)
+{
+	int Teller;
+	FbRect Tile;
+	Tile.w = TileWidth;
+	Tile.h = TileHeight;
+	for (Teller=0;Teller<BoardParts->ItemCount;Teller++)
+	{
+		Tile.x = CPeg_GetX(BoardParts->Items[Teller]);
+		Tile.y = CPeg_GetY(BoardParts->Items[Teller]);
+		if (fbRectIntersects(&Tile, Area))
+			CPeg_Draw(BoardParts->Items[Teller]);
+	}
 }
\ No newline at end of file
@@ -16,6 +16,7 @@ struct CBoardParts
 CBoardParts* CBoardParts_Create(); 
 void CBoardParts_Add(CBoardParts* BoardParts, CPeg *BoardPart); // Add a boardpart
 void CBoardParts_Draw(CBoardParts* BoardParts); // Draw all boardparts
+void CBoardParts_DrawArea(CBoardParts* BoardParts, const FbRect* Area); // Draw only the boardparts touching the area
 CPeg *CBoardParts_GetPart(CBoardParts* BoardParts, const int PlayFieldXin,const int PlayFieldYin); // return a boardpart given the coordinates
 void CBoardParts_RemoveAll(CBoardParts* BoardParts); // remove (free) all boardparts
 void CBoardParts_Destroy(CBoardParts* BoardParts);
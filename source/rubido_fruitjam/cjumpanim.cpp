@@ -0,0 +1,143 @@
+#include "cjumpanim.h"
+#include "cpeg.h"
+#include "tween.h"
+
+CJumpAnim* CJumpAnim_Create()
+{
+	CJumpAnim* Result = (CJumpAnim*) malloc(sizeof(CJumpAnim));
+	Result->Active = false;
+	Result->TweenX = -1;
+	Result->TweenY = -1;
+	Result->TweenFade = -1;
+	for (int I = 0; I < JumpAnimHistory; I++)
+		Result->RectCount[I] = 0;
+	return Result;
+}
+
+void CJumpAnim_Stop(CJumpAnim* Anim)
+{
+	tweenStop(Anim->TweenX);
+	tweenStop(Anim->TweenY);
+	tweenStop(Anim->TweenFade);
+	Anim->TweenX = -1;
+	Anim->TweenY = -1;
+	Anim->TweenFade = -1;
+	Anim->Active = false;
+	for (int I = 0; I < JumpAnimHistory; I++)
+		Anim->RectCount[I] = 0;
+}
+
+void CJumpAnim_Start(CJumpAnim* Anim, CPeg* Source, CPeg* Jumped, CPeg* Target)
+{
+	CJumpAnim_Stop(Anim);
+	if (!Source || !Jumped || !Target)
+		return;
+	Anim->Source = Source;
+	Anim->Jumped = Jumped;
+	Anim->Target = Target;
+	Anim->X = CPeg_GetX(Source);
+	Anim->Y = CPeg_GetY(Source);
+	Anim->FadePhase = 0;
+	Anim->TweenX = tweenStart(CPeg_GetX(Source), CPeg_GetX(Target), JumpAnimFrames, EASE_IN_OUT);
+	Anim->TweenY = tweenStart(CPeg_GetY(Source), CPeg_GetY(Target), JumpAnimFrames, EASE_IN_OUT);
+	// 1 maps to a red peg, 2-5 are the fade frames and 6 is the empty spot
+	Anim->TweenFade = tweenStart(1, 6, JumpAnimFrames, EASE_IN);
+	Anim->Active = (Anim->TweenX >= 0) && (Anim->TweenY >= 0) && (Anim->TweenFade >= 0);
+	if (!Anim->Active)
+		CJumpAnim_Stop(Anim);
+}
+
+static void CJumpAnim_AddTile(CJumpAnim* Anim, CPeg* Peg)
+{
+	FbRect* Rect = &Anim->Rects[0][Anim->RectCount[0]++];
+	Rect->x = CPeg_GetX(Peg);
+	Rect->y = CPeg_GetY(Peg);
+	Rect->w = TileWidth;
+	Rect->h = TileHeight;
+}
+
+void CJumpAnim_Update(CJumpAnim* Anim)
+{
+	// age the history, the oldest frame drops off
+	for (int I = JumpAnimHistory - 1; I > 0; I--)
+	{
+		for (int J = 0; J < Anim->RectCount[I - 1]; J++)
+			Anim->Rects[I][J] = Anim->Rects[I - 1][J];
+		Anim->RectCount[I] = Anim->RectCount[I - 1];
+	}
+	Anim->RectCount[0] = 0;
+
+	if (!Anim->Active)
+		return;
+
+	CJumpAnim_AddTile(Anim, Anim->Source);
+	CJumpAnim_AddTile(Anim, Anim->Jumped);
+	CJumpAnim_AddTile(Anim, Anim->Target);
+
+	if (!tweenIsActive(Anim->TweenX))
+	{
+		// finished, the tiles above get redrawn with their real state
+		Anim->TweenX = -1;
+		Anim->TweenY = -1;
+		Anim->TweenFade = -1;
+		Anim->Active = false;
+		return;
+	}
+
+	Anim->X = tweenGetValue(Anim->TweenX);
+	Anim->Y = tweenGetValue(Anim->TweenY);
+	Anim->FadePhase = tweenGetValue(Anim->TweenFade);
+	if (Anim->FadePhase < 2)
+		Anim->FadePhase = 0;
+
+	FbRect* Rect = &Anim->Rects[0][Anim->RectCount[0]++];
+	Rect->x = Anim->X;
+	Rect->y = Anim->Y;
+	Rect->w = TileWidth;
+	Rect->h = TileHeight;
+}
+
+void CJumpAnim_Draw(CJumpAnim* Anim)
+{
+	if (!Anim->Active)
+		return;
+	CPeg_DrawPhase(Anim->Jumped, Anim->FadePhase);
+	CPeg_DrawPhase(Anim->Target, 6);
+	CPeg_DrawMoving(Anim->X, Anim->Y);
+}
+
+bool CJumpAnim_NeedsRedraw(CJumpAnim* Anim)
+{
+	for (int I = 0; I < JumpAnimHistory; I++)
+		if (Anim->RectCount[I] > 0)
+			return true;
+	return false;
+}
+
+int CJumpAnim_GetDirtyRects(CJumpAnim* Anim, FbRect* Rects, int MaxRects)
+{
+	int Count = 0;
+	for (int I = 0; I < JumpAnimHistory; I++)
+		for (int J = 0; J < Anim->RectCount[I]; J++)
+		{
+			FbRect* Rect = &Anim->Rects[I][J];
+			// the tiles are the same every frame, skip duplicates
+			bool Duplicate = false;
+			for (int K = 0; K < Count; K++)
+				if ((Rects[K].x == Rect->x) && (Rects[K].y == Rect->y) && (Rects[K].w == Rect->w) && (Rects[K].h == Rect->h))
+				{
+					Duplicate = true;
+					break;
+				}
+			if (!Duplicate && (Count < MaxRects))
+				Rects[Count++] = *Rect;
+		}
+	return Count;
+}
+
+void CJumpAnim_Destroy(CJumpAnim* Anim)
+{
+	CJumpAnim_Stop(Anim);
+	free(Anim);
+	Anim = NULL;
+}
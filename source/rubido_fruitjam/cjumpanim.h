@@ -0,0 +1,41 @@
+#ifndef CJUMPANIM_H
+#define CJUMPANIM_H
+
+#include "commonvars.h"
+#include "cpeg.h"
+
+// how many frames the jump takes
+#define JumpAnimFrames 12
+// rectangles touched per frame: source, jumped and target tile + the moving peg
+#define JumpAnimRectsPerFrame 4
+// the display is double buffered so a rect needs redrawing for 2 more frames after it was touched
+#define JumpAnimHistory 3
+
+typedef struct CJumpAnim CJumpAnim;
+
+// Animates a peg sliding from its source to its target spot while the jumped peg
+// fades out through the peg strip frames 2-5
+struct CJumpAnim
+{
+	CPeg *Source, *Jumped, *Target; // board state is already updated, these only get drawn differently
+	int8_t TweenX, TweenY, TweenFade;
+	int X, Y, FadePhase; // current sprite position and fade frame
+	bool Active;
+	FbRect Rects[JumpAnimHistory][JumpAnimRectsPerFrame]; // [0] = current frame
+	int RectCount[JumpAnimHistory];
+};
+
+CJumpAnim* CJumpAnim_Create();
+// start a jump, Source is the peg that moved, Jumped the one removed and Target where it lands
+void CJumpAnim_Start(CJumpAnim* Anim, CPeg* Source, CPeg* Jumped, CPeg* Target);
+void CJumpAnim_Stop(CJumpAnim* Anim);
+// advance one frame, call once per rendered frame after tweenUpdateAll()
+void CJumpAnim_Update(CJumpAnim* Anim);
+// draw the animated tiles and moving peg on top of the board
+void CJumpAnim_Draw(CJumpAnim* Anim);
+// true while there is something left to redraw (also for a few frames after the animation ended)
+bool CJumpAnim_NeedsRedraw(CJumpAnim* Anim);
+// copy the rectangles that need redrawing this frame, returns how many
+int CJumpAnim_GetDirtyRects(CJumpAnim* Anim, FbRect* Rects, int MaxRects);
+void CJumpAnim_Destroy(CJumpAnim* Anim);
+#endif
@@ -29,6 +29,7 @@ DVHSTX16 tft(pinConfig, DVHSTX_RESOLUTION_320x240, true);
 CSelector *GameSelector;
 bool PrintFormShown = false;
 CBoardParts* BoardParts; // boardparts instance that will hold all the boardparts
+CJumpAnim* JumpAnim; // animates the last jump
 int Difficulty = VeryEasy;
 int Moves = 0;
 int BestPegsLeft[4]; // array that holds the best amount of pegs left for each difficulty
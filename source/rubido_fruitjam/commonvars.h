@@ -14,6 +14,7 @@ typedef struct CBoardParts CBoardParts;
 typedef struct CPeg CPeg;
 typedef struct SPoint SPoint;
 typedef struct CSelector CSelector;
+typedef struct CJumpAnim CJumpAnim;
 
 
 
@@ -76,6 +77,8 @@ typedef struct CSelector CSelector;
 #define AUDIO_BUFFER_SIZE 4096
 #define PIN_USB_HOST_VBUS (11u)
 #define FPS 60
+#define FPS_MENU 30 // static menu screens only need to poll input
+#define TRANSITION_FRAMES 12 // length of the transition between game states
 
 #define COLOR_BACKGROUND rgb565(100,120,255)
 #define COLOR_FOREGROUND rgb565(0,10,255)
@@ -93,6 +96,7 @@ extern int Moves;
 extern int BestPegsLeft[4]; // array that holds the best amount of pegs left for each difficulty
 extern int Difficulty;
 extern CBoardParts* BoardParts; // boardparts instance that will hold all the boardparts
+extern CJumpAnim* JumpAnim; // animates the last jump
 
 //titlescreen
 extern CMainMenu* Menu;
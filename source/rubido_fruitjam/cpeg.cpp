@@ -1,6 +1,7 @@
 #include "cpeg.h"
 #include "cboardparts.h"
 #include "commonvars.h"
+#include "drawlist.h"
 #include "images/peg_RGB565_LE.h"
 
 CPeg* CPeg_Create(const int PlayFieldXin,const int PlayFieldYin)
@@ -128,7 +129,43 @@ bool CPeg_CanMoveTo(CPeg* Peg, const int PlayFieldXin,const int PlayFieldYin,boo
 
 void CPeg_Draw(CPeg* Peg) // drawing
 {
-	bufferDrawImage(&fb,Peg->X, Peg->Y, peg_data + (Peg->AnimPhase * TileWidth *TileHeight * sizeof(uint16_t)), TileWidth, TileHeight, false, true, false); 
+	drawListImage(Peg->X, Peg->Y, peg_data + (Peg->AnimPhase * TileWidth *TileHeight * sizeof(uint16_t)), TileWidth, TileHeight, false, true, false); 
+}
+
+void CPeg_DrawPhase(CPeg* Peg, int AnimPhaseIn)
+{
+	drawListImage(Peg->X, Peg->Y, peg_data + (AnimPhaseIn * TileWidth *TileHeight * sizeof(uint16_t)), TileWidth, TileHeight, false, true, false); 
+}
+
+// the peg strip has no transparency, the pixels that differ between a red peg (frame 0)
+// and an empty spot (frame 6) are the peg itself so only draw those
+static void CPeg_DrawMovingClipped(Framebuffer *Fb, int16_t Xin, int16_t Yin)
+{
+	Xin += Fb->originX;
+	Yin += Fb->originY;
+	int X1 = max(Xin, Fb->clipX1) - Xin;
+	int Y1 = max(Yin, Fb->clipY1) - Yin;
+	int X2 = min(Xin + TileWidth, Fb->clipX2) - Xin;
+	int Y2 = min(Yin + TileHeight, Fb->clipY2) - Yin;
+	if ((X2 <= X1) || (Y2 <= Y1))
+		return;
+	const uint16_t *Peg = (const uint16_t *)peg_data + Y1 * TileWidth;
+	const uint16_t *Empty = (const uint16_t *)(peg_data + (6 * TileWidth *TileHeight * sizeof(uint16_t))) + Y1 * TileWidth;
+	uint16_t *Dest = Fb->buffer + (Yin + Y1) * Fb->width + Xin;
+	for (int Y = Y1; Y < Y2; Y++)
+	{
+		for (int X = X1; X < X2; X++)
+			if (Peg[X] != Empty[X])
+				Dest[X] = Peg[X];
+		Peg += TileWidth;
+		Empty += TileWidth;
+		Dest += Fb->width;
+	}
+}
+
+void CPeg_DrawMoving(int Xin, int Yin)
+{
+	drawListCallback(Xin, Yin, TileWidth, TileHeight, CPeg_DrawMovingClipped);
 }
 
 void CPeg_Destroy(CPeg* Peg)
@@ -25,6 +25,8 @@ void CPeg_SetAnimPhase(CPeg* Peg,int AnimPhaseIn);
 void CPeg_SetPosition(CPeg* Peg,const int PlayFieldXin,const int PlayFieldYin);
 bool CPeg_CanMoveTo(CPeg* Peg,const int PlayFieldXin,const int PlayFieldYin,bool erase);
 void CPeg_Draw(CPeg* Peg);
+void CPeg_DrawPhase(CPeg* Peg, int AnimPhaseIn); // draw the tile with another frame then the current animphase
+void CPeg_DrawMoving(int Xin, int Yin); // draw only the peg itself (no hole) at a screen position
 void CPeg_Destroy(CPeg* Peg);
 
 #endif
\ No newline at end of file
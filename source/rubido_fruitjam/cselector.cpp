@@ -1,6 +1,7 @@
 #include "cselector.h"
 #include "commonvars.h"
 #include "framebuffer.h"
+#include "drawlist.h"
 
 CSelector* CSelector_Create(const int PlayFieldXin,const int PlayFieldYin)
 {
@@ -50,11 +51,11 @@ void CSelector_DeSelect(CSelector *Selector)
 
 void CSelector_Draw(CSelector *Selector)
 {
-	bufferDrawRect(&fb, XOffSet - 1 + Selector->CurrentPoint.X * (TileWidth), YOffSet - 1 + Selector->CurrentPoint.Y * (TileHeight), (TileWidth + 2), (TileHeight + 2), COLOR_FOREGROUND);
-	bufferDrawRect(&fb, XOffSet + Selector->CurrentPoint.X * (TileWidth), YOffSet+ Selector->CurrentPoint.Y * (TileHeight), TileWidth, TileHeight, COLOR_BACKGROUND);
-	bufferDrawRect(&fb, XOffSet + 1 + Selector->CurrentPoint.X * (TileWidth), YOffSet + 1 + Selector->CurrentPoint.Y * (TileHeight), (TileWidth-2), (TileHeight-2), COLOR_BACKGROUND);
-	bufferDrawRect(&fb, XOffSet + 2 + Selector->CurrentPoint.X * (TileWidth), YOffSet + 2 + Selector->CurrentPoint.Y * (TileHeight), (TileWidth-4), (TileHeight-4), COLOR_BACKGROUND);
-	bufferDrawRect(&fb, XOffSet + 3 + Selector->CurrentPoint.X * (TileWidth), YOffSet + 3 + Selector->CurrentPoint.Y * (TileHeight), (TileWidth-6), (TileHeight-6), COLOR_FOREGROUND);
+	drawListRect(XOffSet - 1 + Selector->CurrentPoint.X * (TileWidth), YOffSet - 1 + Selector->CurrentPoint.Y * (TileHeight), (TileWidth + 2), (TileHeight + 2), COLOR_FOREGROUND);
+	drawListRect(XOffSet + Selector->CurrentPoint.X * (TileWidth), YOffSet+ Selector->CurrentPoint.Y * (TileHeight), TileWidth, TileHeight, COLOR_BACKGROUND);
+	drawListRect(XOffSet + 1 + Selector->CurrentPoint.X * (TileWidth), YOffSet + 1 + Selector->CurrentPoint.Y * (TileHeight), (TileWidth-2), (TileHeight-2), COLOR_BACKGROUND);
+	drawListRect(XOffSet + 2 + Selector->CurrentPoint.X * (TileWidth), YOffSet + 2 + Selector->CurrentPoint.Y * (TileHeight), (TileWidth-4), (TileHeight-4), COLOR_BACKGROUND);
+	drawListRect(XOffSet + 3 + Selector->CurrentPoint.X * (TileWidth), YOffSet + 3 + Selector->CurrentPoint.Y * (TileHeight), (TileWidth-6), (TileHeight-6), COLOR_FOREGROUND);
 }
 
 void CSelector_Destroy(CSelector *Selector)
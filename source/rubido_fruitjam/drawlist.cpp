@@ -0,0 +1,364 @@
+// drawlist.cpp - recorded draw calls executed band by band with occlusion culling
+// Every command keeps the screen area it can touch (its bounds), executing a band
+// cuts the bounds down to the band, removes what later opaque commands cover and
+// runs the normal framebuffer primitive clipped to each piece that is left
+
+#include "drawlist.h"
+
+enum DrawListCommandType {
+    DRAWLIST_IMAGE,
+    DRAWLIST_IMAGE_TRANSPARENT,
+    DRAWLIST_FILL_RECT,
+    DRAWLIST_RECT,
+    DRAWLIST_TEXT,
+    DRAWLIST_CALLBACK
+};
+
+typedef struct {
+    uint8_t type;
+    uint8_t opaque;        // every pixel inside bounds gets overwritten
+    uint8_t bgr;           // image format / text size
+    uint8_t littleEndian;
+    uint8_t rle;
+    FbRect bounds;         // area the command can touch, clip applied
+    int16_t x, y, w, h;
+    uint16_t color;        // fill / outline / text color, transparent color for images
+    uint16_t bg;           // text background
+    const void* data;      // image data or text (in the text pool)
+    const uint8_t* font;
+    DrawListCallback callback;
+} DrawListCommand;
+
+static Framebuffer* target = NULL;
+static DrawListCommand commands[MAX_DRAWLIST_COMMANDS];
+static uint16_t command_count = 0;
+static char text_pool[DRAWLIST_TEXT_SIZE];
+static uint16_t text_used = 0;
+static FbRect list_clip;
+static uint16_t stats_commands = 0;
+static uint16_t stats_culled = 0;
+static int16_t saved_clip[4];
+static int16_t saved_origin[2];
+
+static inline bool rectIntersection(const FbRect* a, const FbRect* b, FbRect* result) {
+    int16_t x1 = max(a->x, b->x);
+    int16_t y1 = max(a->y, b->y);
+    int16_t x2 = min(a->x + a->w, b->x + b->w);
+    int16_t y2 = min(a->y + a->h, b->y + b->h);
+    if (x2 <= x1 || y2 <= y1) return false;
+    result->x = x1;
+    result->y = y1;
+    result->w = x2 - x1;
+    result->h = y2 - y1;
+    return true;
+}
+
+static inline bool rectContains(const FbRect* outer, const FbRect* inner) {
+    return (inner->x >= outer->x) && (inner->y >= outer->y) &&
+           (inner->x + inner->w <= outer->x + outer->w) && (inner->y + inner->h <= outer->y + outer->h);
+}
+
+void drawListBegin(Framebuffer* fb) {
+    target = (fb && fb->buffer) ? fb : NULL;
+    command_count = 0;
+    text_used = 0;
+    stats_commands = 0;
+    stats_culled = 0;
+    drawListResetClip();
+}
+
+void drawListSetClip(int16_t x, int16_t y, int16_t w, int16_t h) {
+    FbRect clip = {x, y, w, h};
+    FbRect screen = {0, 0, 0, 0};
+    if (target) {
+        screen.w = target->width;
+        screen.h = target->height;
+    }
+    if (!rectIntersection(&clip, &screen, &list_clip)) {
+        list_clip.w = 0;
+        list_clip.h = 0;
+    }
+}
+
+void drawListResetClip() {
+    list_clip.x = 0;
+    list_clip.y = 0;
+    list_clip.w = target ? target->width : 0;
+    list_clip.h = target ? target->height : 0;
+}
+
+// ============================================================================
+// Execution
+// ============================================================================
+
+static void runCommand(const DrawListCommand* cmd, const FbRect* piece) {
+    bufferSetClip(target, piece->x, piece->y, piece->w, piece->h);
+    switch (cmd->type) {
+        case DRAWLIST_IMAGE:
+            bufferDrawImage(target, cmd->x, cmd->y, (const uint8_t*)cmd->data, cmd->w, cmd->h,
+                            cmd->bgr, cmd->littleEndian, cmd->rle);
+            break;
+        case DRAWLIST_IMAGE_TRANSPARENT:
+            bufferDrawImageTransparent(target, cmd->x, cmd->y, (const uint8_t*)cmd->data, cmd->w, cmd->h,
+                                       cmd->bgr, cmd->littleEndian, cmd->rle, cmd->color);
+            break;
+        case DRAWLIST_FILL_RECT:
+            bufferFillRect(target, cmd->x, cmd->y, cmd->w, cmd->h, cmd->color);
+            break;
+        case DRAWLIST_RECT:
+            bufferDrawRect(target, cmd->x, cmd->y, cmd->w, cmd->h, cmd->color);
+            break;
+        case DRAWLIST_TEXT:
+            bufferPrint(target, cmd->x, cmd->y, (const char*)cmd->data, cmd->color, cmd->bg, cmd->bgr, cmd->font);
+            break;
+        case DRAWLIST_CALLBACK:
+            cmd->callback(target, cmd->x, cmd->y);
+            break;
+    }
+}
+
+// Draw the part of command index inside visible that no later opaque command covers.
+// Occluder edges split visible into horizontal slabs, in each slab the occluders
+// spanning it remove x ranges and the gaps between them get drawn
+static void runVisible(uint16_t index, const FbRect* visible) {
+    FbRect occluders[DRAWLIST_MAX_OCCLUDERS];
+    uint8_t count = 0;
+
+    for (uint16_t i = index + 1; i < command_count && count < DRAWLIST_MAX_OCCLUDERS; i++) {
+        if (!commands[i].opaque) continue;
+        FbRect* o = &occluders[count];
+        if (!rectIntersection(&commands[i].bounds, visible, o)) continue;
+        if (rectContains(o, visible)) {
+            stats_culled++;
+            return;
+        }
+        count++;
+    }
+
+    if (count == 0) {
+        runCommand(&commands[index], visible);
+        return;
+    }
+
+    // slab edges, sorted (duplicates give empty slabs that get skipped)
+    int16_t edges[DRAWLIST_MAX_OCCLUDERS * 2 + 2];
+    uint8_t edge_count = 0;
+    edges[edge_count++] = visible->y;
+    edges[edge_count++] = visible->y + visible->h;
+    for (uint8_t i = 0; i < count; i++) {
+        edges[edge_count++] = occluders[i].y;
+        edges[edge_count++] = occluders[i].y + occluders[i].h;
+    }
+    for (uint8_t i = 1; i < edge_count; i++) {
+        int16_t e = edges[i];
+        int8_t j = i - 1;
+        while (j >= 0 && edges[j] > e) {
+            edges[j + 1] = edges[j];
+            j--;
+        }
+        edges[j + 1] = e;
+    }
+
+    for (uint8_t s = 0; s + 1 < edge_count; s++) {
+        int16_t y1 = edges[s];
+        int16_t y2 = edges[s + 1];
+        if (y2 <= y1) continue;
+
+        // x ranges covered in this slab, sorted by their start
+        int16_t starts[DRAWLIST_MAX_OCCLUDERS];
+        int16_t ends[DRAWLIST_MAX_OCCLUDERS];
+        uint8_t ranges = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            if (occluders[i].y > y1 || occluders[i].y + occluders[i].h < y2) continue;
+            int8_t j = ranges - 1;
+            while (j >= 0 && starts[j] > occluders[i].x) {
+                starts[j + 1] = starts[j];
+                ends[j + 1] = ends[j];
+                j--;
+            }
+            starts[j + 1] = occluders[i].x;
+            ends[j + 1] = occluders[i].x + occluders[i].w;
+            ranges++;
+        }
+
+        FbRect piece;
+        piece.y = y1;
+        piece.h = y2 - y1;
+        int16_t x = visible->x;
+        for (uint8_t i = 0; i < ranges; i++) {
+            if (starts[i] > x) {
+                piece.x = x;
+                piece.w = starts[i] - x;
+                runCommand(&commands[index], &piece);
+            }
+            if (ends[i] > x) x = ends[i];
+        }
+        if (x < visible->x + visible->w) {
+            piece.x = x;
+            piece.w = visible->x + visible->w - x;
+            runCommand(&commands[index], &piece);
+        }
+    }
+}
+
+// The primitives get called with buffer coordinates and their own clip,
+// the clip and origin the framebuffer had are put back afterwards
+static void saveView() {
+    saved_clip[0] = target->clipX1;
+    saved_clip[1] = target->clipY1;
+    saved_clip[2] = target->clipX2;
+    saved_clip[3] = target->clipY2;
+    saved_origin[0] = target->originX;
+    saved_origin[1] = target->originY;
+    bufferSetOrigin(target, 0, 0);
+}
+
+static void restoreView() {
+    target->clipX1 = saved_clip[0];
+    target->clipY1 = saved_clip[1];
+    target->clipX2 = saved_clip[2];
+    target->clipY2 = saved_clip[3];
+    bufferSetOrigin(target, saved_origin[0], saved_origin[1]);
+}
+
+static void executeCommands() {
+    if (!target || command_count == 0) return;
+    saveView();
+
+    FbRect band;
+    band.x = 0;
+    band.w = target->width;
+    for (band.y = 0; band.y < target->height; band.y += DRAWLIST_BAND_HEIGHT) {
+        band.h = min(DRAWLIST_BAND_HEIGHT, target->height - band.y);
+        for (uint16_t i = 0; i < command_count; i++) {
+            FbRect visible;
+            if (rectIntersection(&commands[i].bounds, &band, &visible)) {
+                runVisible(i, &visible);
+            }
+        }
+    }
+
+    restoreView();
+
+    stats_commands += command_count;
+    command_count = 0;
+    text_used = 0;
+}
+
+void drawListExecute() {
+    executeCommands();
+    target = NULL;
+}
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+// Next free command with its bounds set, NULL when it would not be visible
+static DrawListCommand* addCommand(uint8_t type, int16_t x, int16_t y, int16_t w, int16_t h) {
+    if (!target) return NULL;
+    FbRect area = {x, y, w, h};
+    FbRect bounds;
+    if (!rectIntersection(&area, &list_clip, &bounds)) return NULL;
+    if (command_count >= MAX_DRAWLIST_COMMANDS) executeCommands();
+
+    DrawListCommand* cmd = &commands[command_count++];
+    cmd->type = type;
+    cmd->opaque = 0;
+    cmd->bounds = bounds;
+    cmd->x = x;
+    cmd->y = y;
+    cmd->w = w;
+    cmd->h = h;
+    return cmd;
+}
+
+void drawListImage(int16_t x, int16_t y, const uint8_t* image, int16_t w, int16_t h,
+                   uint8_t bgr, uint8_t littleEndian, uint8_t rle) {
+    if (!image) return;
+    DrawListCommand* cmd = addCommand(DRAWLIST_IMAGE, x, y, w, h);
+    if (!cmd) return;
+    cmd->opaque = 1;
+    cmd->data = image;
+    cmd->bgr = bgr;
+    cmd->littleEndian = littleEndian;
+    cmd->rle = rle;
+}
+
+void drawListImageTransparent(int16_t x, int16_t y, const uint8_t* image, int16_t w, int16_t h,
+                              uint8_t bgr, uint8_t littleEndian, uint8_t rle, uint16_t transparentColor) {
+    if (!image) return;
+    DrawListCommand* cmd = addCommand(DRAWLIST_IMAGE_TRANSPARENT, x, y, w, h);
+    if (!cmd) return;
+    cmd->data = image;
+    cmd->bgr = bgr;
+    cmd->littleEndian = littleEndian;
+    cmd->rle = rle;
+    cmd->color = transparentColor;
+}
+
+void drawListFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    DrawListCommand* cmd = addCommand(DRAWLIST_FILL_RECT, x, y, w, h);
+    if (!cmd) return;
+    cmd->opaque = 1;
+    cmd->color = color;
+}
+
+void drawListRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    DrawListCommand* cmd = addCommand(DRAWLIST_RECT, x, y, w, h);
+    if (!cmd) return;
+    cmd->color = color;
+}
+
+void drawListPrint(int16_t x, int16_t y, const char* str, uint16_t color, uint16_t bg, uint8_t size, const uint8_t* font) {
+    if (!str || !font || !target) return;
+
+    // bounds of the text, same layout as bufferPrint
+    size_t len = 0;
+    int16_t columns = 0, line = 0, lines = 1;
+    for (const char* c = str; *c; c++, len++) {
+        if (*c == '\n') {
+            lines++;
+            line = 0;
+        } else if (++line > columns) {
+            columns = line;
+        }
+    }
+
+    if (text_used + len + 1 > DRAWLIST_TEXT_SIZE) {
+        executeCommands();
+        if (len + 1 > DRAWLIST_TEXT_SIZE) {
+            // does not fit at all, draw it right away (everything before it is drawn already)
+            saveView();
+            bufferSetClip(target, list_clip.x, list_clip.y, list_clip.w, list_clip.h);
+            bufferPrint(target, x, y, str, color, bg, size, font);
+            restoreView();
+            return;
+        }
+    }
+
+    DrawListCommand* cmd = addCommand(DRAWLIST_TEXT, x, y, columns * 6 * size, lines * 9 * size);
+    if (!cmd) return;
+    memcpy(text_pool + text_used, str, len + 1);
+    cmd->data = text_pool + text_used;
+    text_used += len + 1;
+    cmd->color = color;
+    cmd->bg = bg;
+    cmd->bgr = size;
+    cmd->font = font;
+}
+
+void drawListCallback(int16_t x, int16_t y, int16_t w, int16_t h, DrawListCallback callback) {
+    if (!callback) return;
+    DrawListCommand* cmd = addCommand(DRAWLIST_CALLBACK, x, y, w, h);
+    if (!cmd) return;
+    cmd->callback = callback;
+}
+
+uint16_t drawListGetCommandCount() {
+    return stats_commands;
+}
+
+uint16_t drawListGetCulledCount() {
+    return stats_culled;
+}
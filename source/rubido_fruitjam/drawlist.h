@@ -0,0 +1,55 @@
+#ifndef DRAWLIST_H
+#define DRAWLIST_H
+
+#include <stdint.h>
+#include "framebuffer.h"
+
+// Configuration
+#ifndef MAX_DRAWLIST_COMMANDS
+#define MAX_DRAWLIST_COMMANDS 128
+#endif
+#ifndef DRAWLIST_TEXT_SIZE
+#define DRAWLIST_TEXT_SIZE 512     // bytes for copies of the strings drawn this frame
+#endif
+#ifndef DRAWLIST_BAND_HEIGHT
+#define DRAWLIST_BAND_HEIGHT 16    // scanlines drawn per pass
+#endif
+#define DRAWLIST_MAX_OCCLUDERS 24  // later opaque commands looked at per visible piece
+
+// Command list renderer: draw calls are recorded during the frame and executed
+// band by band, each band gets all commands touching it before moving on.
+// Parts of commands hidden by later opaque commands (images, filled rects) are
+// not drawn, so covered pixels get written once instead of once per layer.
+// Typical usage:
+//   drawListBegin(&fb);
+//   drawListImage(0, 0, background_data, 320, 240, 0, 1, 0);
+//   drawListPrint(242, 37, "Moves:3", color, color, 1, font);
+//   drawListExecute();
+// Coordinates are buffer coordinates, the framebuffer clip / origin are restored afterwards.
+// If the list or text pool runs full the commands so far are executed and recording goes on.
+// RLE images decode from their start in every band, use raw images in a draw list.
+
+// Draws the command at x,y, must stay inside the clip rectangle of fb
+typedef void (*DrawListCallback)(Framebuffer* fb, int16_t x, int16_t y);
+
+void drawListBegin(Framebuffer* fb);
+void drawListExecute();
+
+// Clip for the commands recorded after it, in buffer coordinates
+void drawListSetClip(int16_t x, int16_t y, int16_t w, int16_t h);
+void drawListResetClip();
+
+void drawListImage(int16_t x, int16_t y, const uint8_t* image, int16_t w, int16_t h,
+                   uint8_t bgr, uint8_t littleEndian, uint8_t rle);
+void drawListImageTransparent(int16_t x, int16_t y, const uint8_t* image, int16_t w, int16_t h,
+                              uint8_t bgr, uint8_t littleEndian, uint8_t rle, uint16_t transparentColor);
+void drawListFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+void drawListRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+void drawListPrint(int16_t x, int16_t y, const char* str, uint16_t color, uint16_t bg, uint8_t size, const uint8_t* font);
+// custom drawing inside the w x h area at x,y
+void drawListCallback(int16_t x, int16_t y, int16_t w, int16_t h, DrawListCallback callback);
+
+// Statistics of the last execute
+uint16_t drawListGetCommandCount();
+uint16_t drawListGetCulledCount();   // command / band pieces that were completely hidden
+#endif
@@ -30,6 +30,7 @@ Framebuffer* createFramebuffer(int16_t width, int16_t height, uint8_t littleEndi
     fb->height = height;
     fb->littleEndian = littleEndian;
     fb->bgr = bgr;
+    bufferResetClip(fb);
     fb->buffer = (uint16_t*)malloc(width * height * sizeof(uint16_t));
     
     if (!fb->buffer) {
@@ -53,10 +54,86 @@ void destroyFramebuffer(Framebuffer* fb) {
     }
 }
 
+// ============================================================================
+// Clip rectangle and origin
+// ============================================================================
+
+// Clip to the whole buffer and put the origin back at 0,0
+void bufferResetClip(Framebuffer* fb) {
+    if (!fb) return;
+    fb->clipX1 = 0;
+    fb->clipY1 = 0;
+    fb->clipX2 = fb->width;
+    fb->clipY2 = fb->height;
+    fb->originX = 0;
+    fb->originY = 0;
+}
+
+// Clip rectangle in buffer coordinates, limited to the buffer itself
+void bufferSetClip(Framebuffer* fb, int16_t x, int16_t y, int16_t w, int16_t h) {
+    if (!fb) return;
+    fb->clipX1 = constrain(x, 0, fb->width);
+    fb->clipY1 = constrain(y, 0, fb->height);
+    fb->clipX2 = constrain(x + w, fb->clipX1, fb->width);
+    fb->clipY2 = constrain(y + h, fb->clipY1, fb->height);
+}
+
+void bufferSetOrigin(Framebuffer* fb, int16_t x, int16_t y) {
+    if (!fb) return;
+    fb->originX = x;
+    fb->originY = y;
+}
+
+// Sub view: only the view gets drawn to and its top left becomes 0,0
+void bufferSetViewport(Framebuffer* fb, const FbRect* view) {
+    if (!fb || !view) return;
+    bufferSetClip(fb, view->x, view->y, view->w, view->h);
+    bufferSetOrigin(fb, view->x, view->y);
+}
+
+// ============================================================================
+// Lines and shapes
+// All of them test their bounding box against the clip rectangle once: fully
+// outside draws nothing, fully inside uses the unclipped inner routines and
+// only shapes crossing the clip edge pay for clipping
+// ============================================================================
+
+static inline void shapeSpan(Framebuffer* fb, int16_t x, int16_t y, int16_t w, uint16_t color, bool inside) {
+    if (inside) {
+        bufferDrawHSpanUnclipped(fb, x, y, w, color);
+    } else {
+        bufferDrawHSpanClipped(fb, x, y, w, color);
+    }
+}
+
 // Draw a line using Bresenham's algorithm
 void bufferDrawLine(Framebuffer* fb, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
     if (!fb || !fb->buffer) return;
     
+    x0 += fb->originX;
+    y0 += fb->originY;
+    x1 += fb->originX;
+    y1 += fb->originY;
+    
+    // Straight lines are spans
+    if (y0 == y1) {
+        if (x0 > x1) _swap_int16_t(x0, x1);
+        bufferDrawHSpanClipped(fb, x0, y0, x1 - x0 + 1, color);
+        return;
+    }
+    if (x0 == x1) {
+        if (y0 > y1) _swap_int16_t(y0, y1);
+        bufferDrawVSpanClipped(fb, x0, y0, y1 - y0 + 1, color);
+        return;
+    }
+    
+    int16_t left = min(x0, x1);
+    int16_t top = min(y0, y1);
+    int16_t right = max(x0, x1);
+    int16_t bottom = max(y0, y1);
+    if (right < fb->clipX1 || left >= fb->clipX2 || bottom < fb->clipY1 || top >= fb->clipY2) return;
+    bool inside = bufferClipContains(fb, left, top, right - left + 1, bottom - top + 1);
+    
     int16_t steep = abs(y1 - y0) > abs(x1 - x0);
     
     if (steep) {
@@ -73,13 +150,30 @@ void bufferDrawLine(Framebuffer* fb, int16_t x0, int16_t y0, int16_t x1, int16_t
     int16_t dy = abs(y1 - y0);
     int16_t err = dx / 2;
     int16_t ystep = (y0 < y1) ? 1 : -1;
+    
+    if (inside) {
+        // Walk a pointer, one step along the major axis per pixel
+        uint16_t* ptr = steep ? fb->buffer + (x0 * fb->width + y0) : fb->buffer + (y0 * fb->width + x0);
+        int32_t majorStep = steep ? fb->width : 1;
+        int32_t minorStep = steep ? ystep : ystep * fb->width;
+        for (int16_t x = x0; x <= x1; x++) {
+            *ptr = color;
+            ptr += majorStep;
+            err -= dy;
+            if (err < 0) {
+                ptr += minorStep;
+                err += dx;
+            }
+        }
+        return;
+    }
+    
     int16_t y = y0;
-
     for (int16_t x = x0; x <= x1; x++) {
-        if (steep) {
-            bufferDrawPixel(fb, y, x, color);
-        } else {
-            bufferDrawPixel(fb, x, y, color);
+        int16_t px = steep ? y : x;
+        int16_t py = steep ? x : y;
+        if (px >= fb->clipX1 && px < fb->clipX2 && py >= fb->clipY1 && py < fb->clipY2) {
+            bufferDrawPixelUnclipped(fb, px, py, color);
         }
         err -= dy;
         if (err < 0) {
@@ -89,73 +183,103 @@ void bufferDrawLine(Framebuffer* fb, int16_t x0, int16_t y0, int16_t x1, int16_t
     }
 }
 
-// Draw a circle outline
-void bufferDrawCircle(Framebuffer* fb, int16_t x0, int16_t y0, int16_t r, uint16_t color) {
-    if (!fb || !fb->buffer) return;
-    
-    int16_t f = 1 - r;
-    int16_t ddF_x = 1;
-    int16_t ddF_y = -2 * r;
-    int16_t x = 0;
-    int16_t y = r;
-
-    bufferDrawPixel(fb, x0, y0 + r, color);
-    bufferDrawPixel(fb, x0, y0 - r, color);
-    bufferDrawPixel(fb, x0 + r, y0, color);
-    bufferDrawPixel(fb, x0 - r, y0, color);
+// Half width of the ellipse row dy (0..ry) from the centre, starting the search at x.
+// A pixel belongs to the ellipse when its centre lies inside the ellipse with radii
+// rx + 0.5, ry + 0.5: 4x^2(2ry+1)^2 + 4dy^2(2rx+1)^2 <= (2rx+1)^2(2ry+1)^2
+// Rows get narrower going outwards so x only ever steps down, O(rx + ry) for a whole shape
+static inline int16_t ellipseRowExtent(int16_t x, int16_t dy, int64_t a, int64_t b, int64_t ab) {
+    int64_t yTerm = 4 * (int64_t)dy * dy * a;
+    while (x > 0 && 4 * (int64_t)x * x * b + yTerm > ab) x--;
+    return x;
+}
 
-    while (x < y) {
-        if (f >= 0) {
-            y--;
-            ddF_y += 2;
-            f += ddF_y;
+// Outline or fill of a shape made of 4 quarter ellipses with radii rx / ry around
+// (xl,yt) (xr,yt) (xl,yb) (xr,yb) joined by straight edges. Circles, ellipses and
+// rounded rectangles all use it. Buffer coordinates.
+// The outline is drawn as spans: on each row it runs from the row's own extent in to
+// just past the extent of the next row out (at least 1 pixel). That is the edge of the
+// filled shape, not the pixels the old midpoint routines plotted: small shapes come out
+// fuller (r=1 is a 3x3 ring of 8 pixels where the midpoint circle had 4) and larger
+// ones can gain or lose a pixel where the edge changes direction
+static void bufferRoundedShape(Framebuffer* fb, int16_t xl, int16_t yt, int16_t xr, int16_t yb,
+                               int16_t rx, int16_t ry, uint16_t color, bool fill) {
+    int16_t left = xl - rx;
+    int16_t top = yt - ry;
+    int16_t right = xr + rx;
+    int16_t bottom = yb + ry;
+    if (right < fb->clipX1 || left >= fb->clipX2 || bottom < fb->clipY1 || top >= fb->clipY2) return;
+    bool inside = bufferClipContains(fb, left, top, right - left + 1, bottom - top + 1);
+    
+    int64_t a = (int64_t)(2 * rx + 1) * (2 * rx + 1);
+    int64_t b = (int64_t)(2 * ry + 1) * (2 * ry + 1);
+    int64_t ab = a * b;
+    int16_t extent = rx;
+    
+    for (int16_t dy = 0; dy <= ry; dy++) {
+        int16_t next = (dy < ry) ? ellipseRowExtent(extent, dy + 1, a, b, ab) : -1;
+        int16_t rowTop = yt - dy;
+        int16_t rowBottom = yb + dy;
+        
+        if (fill) {
+            shapeSpan(fb, xl - extent, rowTop, xr - xl + 2 * extent + 1, color, inside);
+            if (rowBottom != rowTop) {
+                shapeSpan(fb, xl - extent, rowBottom, xr - xl + 2 * extent + 1, color, inside);
+            }
+        } else {
+            int16_t inner = min(next, extent - 1) + 1;
+            if (inner <= 0) {
+                // top / bottom row, one span across
+                shapeSpan(fb, xl - extent, rowTop, xr - xl + 2 * extent + 1, color, inside);
+                if (rowBottom != rowTop) {
+                    shapeSpan(fb, xl - extent, rowBottom, xr - xl + 2 * extent + 1, color, inside);
+                }
+            } else {
+                int16_t w = extent - inner + 1;
+                shapeSpan(fb, xl - extent, rowTop, w, color, inside);
+                shapeSpan(fb, xr + inner, rowTop, w, color, inside);
+                if (rowBottom != rowTop) {
+                    shapeSpan(fb, xl - extent, rowBottom, w, color, inside);
+                    shapeSpan(fb, xr + inner, rowBottom, w, color, inside);
+                }
+            }
+        }
+        extent = next;
+    }
+    
+    // Straight sides between the top and bottom corners
+    if (yb - yt > 1) {
+        int16_t y = yt + 1;
+        int16_t h = yb - yt - 1;
+        if (fill) {
+            int16_t x = left;
+            int16_t w = right - left + 1;
+            if (inside || bufferClipRect(fb, &x, &y, &w, &h)) {
+                bufferFillRectUnclipped(fb, x, y, w, h, color);
+            }
+        } else if (inside) {
+            bufferDrawVSpanUnclipped(fb, left, y, h, color);
+            bufferDrawVSpanUnclipped(fb, right, y, h, color);
+        } else {
+            bufferDrawVSpanClipped(fb, left, y, h, color);
+            bufferDrawVSpanClipped(fb, right, y, h, color);
         }
-        x++;
-        ddF_x += 2;
-        f += ddF_x;
-
-        bufferDrawPixel(fb, x0 + x, y0 + y, color);
-        bufferDrawPixel(fb, x0 - x, y0 + y, color);
-        bufferDrawPixel(fb, x0 + x, y0 - y, color);
-        bufferDrawPixel(fb, x0 - x, y0 - y, color);
-        bufferDrawPixel(fb, x0 + y, y0 + x, color);
-        bufferDrawPixel(fb, x0 - y, y0 + x, color);
-        bufferDrawPixel(fb, x0 + y, y0 - x, color);
-        bufferDrawPixel(fb, x0 - y, y0 - x, color);
     }
 }
 
+// Draw a circle outline
+void bufferDrawCircle(Framebuffer* fb, int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    if (!fb || !fb->buffer || r < 0) return;
+    x0 += fb->originX;
+    y0 += fb->originY;
+    bufferRoundedShape(fb, x0, y0, x0, y0, r, r, color, false);
+}
+
 // Draw a filled circle
 void bufferFillCircle(Framebuffer* fb, int16_t x0, int16_t y0, int16_t r, uint16_t color) {
-    if (!fb || !fb->buffer) return;
-    
-    int16_t f = 1 - r;
-    int16_t ddF_x = 1;
-    int16_t ddF_y = -2 * r;
-    int16_t x = 0;
-    int16_t y = r;
-
-    // Draw center horizontal line through the middle
-    bufferDrawFastHLine(fb, x0 - r, y0, 2 * r + 1, color);
-
-    while (x < y) {
-        if (f >= 0) {
-            y--;
-            ddF_y += 2;
-            f += ddF_y;
-        }
-        x++;
-        ddF_x += 2;
-        f += ddF_x;
-
-        // Draw horizontal lines at +/- x distance
-        bufferDrawFastHLine(fb, x0 - x, y0 + y, 2 * x + 1, color);
-        bufferDrawFastHLine(fb, x0 - x, y0 - y, 2 * x + 1, color);
-        
-        // Draw horizontal lines at +/- y distance
-        bufferDrawFastHLine(fb, x0 - y, y0 + x, 2 * y + 1, color);
-        bufferDrawFastHLine(fb, x0 - y, y0 - x, 2 * y + 1, color);
-    }
+    if (!fb || !fb->buffer || r < 0) return;
+    x0 += fb->originX;
+    y0 += fb->originY;
+    bufferRoundedShape(fb, x0, y0, x0, y0, r, r, color, true);
 }
 
 // Draw a triangle outline
@@ -171,6 +295,13 @@ void bufferDrawTriangle(Framebuffer* fb, int16_t x0, int16_t y0, int16_t x1, int
 void bufferFillTriangle(Framebuffer* fb, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color) {
     if (!fb || !fb->buffer) return;
     
+    x0 += fb->originX;
+    y0 += fb->originY;
+    x1 += fb->originX;
+    y1 += fb->originY;
+    x2 += fb->originX;
+    y2 += fb->originY;
+    
     int16_t a, b, y, last;
 
     // Sort coordinates by Y order (y2 >= y1 >= y0)
@@ -186,14 +317,14 @@ void bufferFillTriangle(Framebuffer* fb, int16_t x0, int16_t y0, int16_t x1, int
         _swap_int16_t(y0, y1);
         _swap_int16_t(x0, x1);
     }
+    
+    int16_t left = min(x0, min(x1, x2));
+    int16_t right = max(x0, max(x1, x2));
+    if (right < fb->clipX1 || left >= fb->clipX2 || y2 < fb->clipY1 || y0 >= fb->clipY2) return;
+    bool inside = bufferClipContains(fb, left, y0, right - left + 1, y2 - y0 + 1);
 
     if (y0 == y2) {
-        a = b = x0;
-        if (x1 < a) a = x1;
-        else if (x1 > b) b = x1;
-        if (x2 < a) a = x2;
-        else if (x2 > b) b = x2;
-        bufferDrawFastHLine(fb, a, y0, b - a + 1, color);
+        shapeSpan(fb, left, y0, right - left + 1, color, inside);
         return;
     }
 
@@ -218,7 +349,7 @@ void bufferFillTriangle(Framebuffer* fb, int16_t x0, int16_t y0, int16_t x1, int
         sa += dx01;
         sb += dx02;
         if (a > b) _swap_int16_t(a, b);
-        bufferDrawFastHLine(fb, a, y, b - a + 1, color);
+        shapeSpan(fb, a, y, b - a + 1, color, inside);
     }
 
     sa = (int32_t)dx12 * (y - y1);
@@ -229,241 +360,97 @@ void bufferFillTriangle(Framebuffer* fb, int16_t x0, int16_t y0, int16_t x1, int
         sa += dx12;
         sb += dx02;
         if (a > b) _swap_int16_t(a, b);
-        bufferDrawFastHLine(fb, a, y, b - a + 1, color);
+        shapeSpan(fb, a, y, b - a + 1, color, inside);
     }
 }
 
-// Draw an ellipse outline - FIXED VERSION
+// Draw an ellipse outline
 void bufferDrawEllipse(Framebuffer* fb, int16_t x0, int16_t y0, int16_t rx, int16_t ry, uint16_t color) {
     if (!fb || !fb->buffer) return;
     if (rx < 0 || ry < 0) return;
-    
-    // Midpoint ellipse algorithm
-    int32_t rx2 = (int32_t)rx * rx;
-    int32_t ry2 = (int32_t)ry * ry;
-    int32_t two_rx2 = 2 * rx2;
-    int32_t two_ry2 = 2 * ry2;
-    
-    int16_t x = 0;
-    int16_t y = ry;
-    int32_t px = 0;
-    int32_t py = two_rx2 * y;
-    
-    // Plot initial points
-    bufferDrawPixel(fb, x0 + x, y0 + y, color);
-    bufferDrawPixel(fb, x0 - x, y0 + y, color);
-    bufferDrawPixel(fb, x0 + x, y0 - y, color);
-    bufferDrawPixel(fb, x0 - x, y0 - y, color);
-    
-    // Region 1
-    int32_t p = ry2 - (rx2 * ry) + (rx2 / 4);
-    while (px < py) {
-        x++;
-        px += two_ry2;
-        if (p < 0) {
-            p += ry2 + px;
-        } else {
-            y--;
-            py -= two_rx2;
-            p += ry2 + px - py;
-        }
-        
-        bufferDrawPixel(fb, x0 + x, y0 + y, color);
-        bufferDrawPixel(fb, x0 - x, y0 + y, color);
-        bufferDrawPixel(fb, x0 + x, y0 - y, color);
-        bufferDrawPixel(fb, x0 - x, y0 - y, color);
-    }
-    
-    // Region 2
-    p = ry2 * (x * x + x) + rx2 * (y - 1) * (y - 1) - rx2 * ry2;
-    while (y > 0) {
-        y--;
-        py -= two_rx2;
-        if (p > 0) {
-            p += rx2 - py;
-        } else {
-            x++;
-            px += two_ry2;
-            p += rx2 - py + px;
-        }
-        
-        bufferDrawPixel(fb, x0 + x, y0 + y, color);
-        bufferDrawPixel(fb, x0 - x, y0 + y, color);
-        bufferDrawPixel(fb, x0 + x, y0 - y, color);
-        bufferDrawPixel(fb, x0 - x, y0 - y, color);
-    }
+    x0 += fb->originX;
+    y0 += fb->originY;
+    bufferRoundedShape(fb, x0, y0, x0, y0, rx, ry, color, false);
 }
 
-// Draw a filled ellipse - FIXED VERSION
+// Draw a filled ellipse
 void bufferFillEllipse(Framebuffer* fb, int16_t x0, int16_t y0, int16_t rx, int16_t ry, uint16_t color) {
     if (!fb || !fb->buffer) return;
     if (rx < 0 || ry < 0) return;
-    
-    // Midpoint ellipse algorithm with horizontal line filling
-    int32_t rx2 = (int32_t)rx * rx;
-    int32_t ry2 = (int32_t)ry * ry;
-    int32_t two_rx2 = 2 * rx2;
-    int32_t two_ry2 = 2 * ry2;
-    
-    int16_t x = 0;
-    int16_t y = ry;
-    int32_t px = 0;
-    int32_t py = two_rx2 * y;
-    
-    // Draw initial horizontal line
-    bufferDrawFastHLine(fb, x0 - x, y0 + y, 2 * x + 1, color);
-    bufferDrawFastHLine(fb, x0 - x, y0 - y, 2 * x + 1, color);
-    
-    // Region 1
-    int32_t p = ry2 - (rx2 * ry) + (rx2 / 4);
-    while (px < py) {
-        x++;
-        px += two_ry2;
-        if (p < 0) {
-            p += ry2 + px;
-        } else {
-            y--;
-            py -= two_rx2;
-            p += ry2 + px - py;
-        }
-        
-        bufferDrawFastHLine(fb, x0 - x, y0 + y, 2 * x + 1, color);
-        bufferDrawFastHLine(fb, x0 - x, y0 - y, 2 * x + 1, color);
-    }
-    
-    // Region 2
-    p = ry2 * (x * x + x) + rx2 * (y - 1) * (y - 1) - rx2 * ry2;
-    while (y > 0) {
-        y--;
-        py -= two_rx2;
-        if (p > 0) {
-            p += rx2 - py;
-        } else {
-            x++;
-            px += two_ry2;
-            p += rx2 - py + px;
-        }
-        
-        bufferDrawFastHLine(fb, x0 - x, y0 + y, 2 * x + 1, color);
-        bufferDrawFastHLine(fb, x0 - x, y0 - y, 2 * x + 1, color);
-    }
+    x0 += fb->originX;
+    y0 += fb->originY;
+    bufferRoundedShape(fb, x0, y0, x0, y0, rx, ry, color, true);
 }
 
-// Draw a rounded rectangle outline - FIXED VERSION
+// Draw a rounded rectangle outline
 void bufferDrawRoundRect(Framebuffer* fb, int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) {
     if (!fb || !fb->buffer) return;
-    
-    // Draw the four edges (not including corners)
-    bufferDrawFastHLine(fb, x + r, y, w - 2 * r, color);                    // Top
-    bufferDrawFastHLine(fb, x + r, y + h - 1, w - 2 * r, color);            // Bottom
-    bufferDrawFastVLine(fb, x, y + r, h - 2 * r, color);                    // Left
-    bufferDrawFastVLine(fb, x + w - 1, y + r, h - 2 * r, color);            // Right
-
-    // Draw the four rounded corners using circle algorithm
-    int16_t f = 1 - r;
-    int16_t ddF_x = 1;
-    int16_t ddF_y = -2 * r;
-    int16_t cx = 0;
-    int16_t cy = r;
-
-    while (cx < cy) {
-        if (f >= 0) {
-            cy--;
-            ddF_y += 2;
-            f += ddF_y;
-        }
-        cx++;
-        ddF_x += 2;
-        f += ddF_x;
-
-        // Top-left corner (quadrant 2)
-        bufferDrawPixel(fb, x + r - cx, y + r - cy, color);
-        bufferDrawPixel(fb, x + r - cy, y + r - cx, color);
-        
-        // Top-right corner (quadrant 1)
-        bufferDrawPixel(fb, x + w - r - 1 + cx, y + r - cy, color);
-        bufferDrawPixel(fb, x + w - r - 1 + cy, y + r - cx, color);
-        
-        // Bottom-left corner (quadrant 3)
-        bufferDrawPixel(fb, x + r - cx, y + h - r - 1 + cy, color);
-        bufferDrawPixel(fb, x + r - cy, y + h - r - 1 + cx, color);
-        
-        // Bottom-right corner (quadrant 4)
-        bufferDrawPixel(fb, x + w - r - 1 + cx, y + h - r - 1 + cy, color);
-        bufferDrawPixel(fb, x + w - r - 1 + cy, y + h - r - 1 + cx, color);
-    }
+    if (w <= 0 || h <= 0) return;
+    r = constrain(r, 0, min(w, h) / 2);
+    x += fb->originX;
+    y += fb->originY;
+    bufferRoundedShape(fb, x + r, y + r, x + w - r - 1, y + h - r - 1, r, r, color, false);
 }
 
 // Draw a filled rounded rectangle
 void bufferFillRoundRect(Framebuffer* fb, int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) {
     if (!fb || !fb->buffer) return;
-    
-    bufferFillRect(fb, x + r, y, w - 2 * r, h, color);
-    bufferFillRect(fb, x, y + r, r, h - 2 * r, color);
-    bufferFillRect(fb, x + w - r, y + r, r, h - 2 * r, color);
-
-    int16_t f = 1 - r;
-    int16_t ddF_x = 1;
-    int16_t ddF_y = -2 * r;
-    int16_t cx = 0;
-    int16_t cy = r;
-
-    while (cx < cy) {
-        if (f >= 0) {
-            cy--;
-            ddF_y += 2;
-            f += ddF_y;
-        }
-        cx++;
-        ddF_x += 2;
-        f += ddF_x;
-
-        bufferDrawFastHLine(fb, x + r - cx, y + r - cy, 2 * cx + 1, color);
-        bufferDrawFastHLine(fb, x + w - r - cx - 1, y + r - cy, 2 * cx + 1, color);
-        bufferDrawFastHLine(fb, x + r - cy, y + r - cx, 2 * cy + 1, color);
-        bufferDrawFastHLine(fb, x + w - r - cy - 1, y + r - cx, 2 * cy + 1, color);
-        
-        bufferDrawFastHLine(fb, x + r - cx, y + h - r - 1 + cy, 2 * cx + 1, color);
-        bufferDrawFastHLine(fb, x + w - r - cx - 1, y + h - r - 1 + cy, 2 * cx + 1, color);
-        bufferDrawFastHLine(fb, x + r - cy, y + h - r - 1 + cx, 2 * cy + 1, color);
-        bufferDrawFastHLine(fb, x + w - r - cy - 1, y + h - r - 1 + cx, 2 * cy + 1, color);
-    }
+    if (w <= 0 || h <= 0) return;
+    r = constrain(r, 0, min(w, h) / 2);
+    x += fb->originX;
+    y += fb->originY;
+    bufferRoundedShape(fb, x + r, y + r, x + w - r - 1, y + h - r - 1, r, r, color, true);
 }
 
 // Draw a character
 void bufferDrawChar(Framebuffer* fb, int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size, const uint8_t* font) {
     if (!fb || !fb->buffer || !font) return;
     
+    x += fb->originX;
+    y += fb->originY;
+    
+    // 5x8 glyph + 1 column spacing
+    int16_t w = 6 * size;
+    int16_t h = 8 * size;
+    if (x + w <= fb->clipX1 || x >= fb->clipX2 || y + h <= fb->clipY1 || y >= fb->clipY2) return;
+    bool inside = bufferClipContains(fb, x, y, w, h);
+    bool opaque = (bg != color);
+    
     if (c >= 176) c++;
     
     for (int8_t i = 0; i < 5; i++) {
         uint8_t line = pgm_read_byte(&font[c * 5 + i]);
         
         for (int8_t j = 0; j < 8; j++) {
-            if (line & 0x1) {
-                if (size == 1) {
-                    bufferDrawPixel(fb, x + i, y + j, color);
-                } else {
-                    bufferFillRect(fb, x + i * size, y + j * size, size, size, color);
-                }
-            } else if (bg != color) {
-                if (size == 1) {
-                    bufferDrawPixel(fb, x + i, y + j, bg);
+            if ((line & 0x1) || opaque) {
+                uint16_t pixel = (line & 0x1) ? color : bg;
+                int16_t px = x + i * size;
+                int16_t py = y + j * size;
+                if (inside) {
+                    if (size == 1) {
+                        bufferDrawPixelUnclipped(fb, px, py, pixel);
+                    } else {
+                        bufferFillRectUnclipped(fb, px, py, size, size, pixel);
+                    }
                 } else {
-                    bufferFillRect(fb, x + i * size, y + j * size, size, size, bg);
+                    int16_t pw = size;
+                    int16_t ph = size;
+                    if (bufferClipRect(fb, &px, &py, &pw, &ph)) {
+                        bufferFillRectUnclipped(fb, px, py, pw, ph, pixel);
+                    }
                 }
             }
             line >>= 1;
         }
     }
     
-    if (bg != color) {
-        if (size == 1) {
-            for (int8_t j = 0; j < 8; j++) {
-                bufferDrawPixel(fb, x + 5, y + j, bg);
-            }
-        } else {
-            bufferFillRect(fb, x + 5 * size, y, size, 8 * size, bg);
+    if (opaque) {
+        int16_t px = x + 5 * size;
+        int16_t py = y;
+        int16_t pw = size;
+        int16_t ph = h;
+        if (inside || bufferClipRect(fb, &px, &py, &pw, &ph)) {
+            bufferFillRectUnclipped(fb, px, py, pw, ph, bg);
         }
     }
 }
@@ -554,6 +541,9 @@ void bufferPrintFloat(Framebuffer* fb, int16_t x, int16_t y, float value, int de
 void blitFramebuffer(Framebuffer* dest, int16_t destX, int16_t destY, Framebuffer* src, int16_t srcX, int16_t srcY, int16_t w, int16_t h) {
     if (!dest || !dest->buffer || !src || !src->buffer) return;
     
+    destX += dest->originX;
+    destY += dest->originY;
+    
     // Clip source coordinates
     if (srcX < 0) {
         w += srcX;
@@ -569,18 +559,18 @@ void blitFramebuffer(Framebuffer* dest, int16_t destX, int16_t destY, Framebuffe
     if (srcY + h > src->height) h = src->height - srcY;
     
     // Clip destination coordinates
-    if (destX < 0) {
-        w += destX;
-        srcX -= destX;
-        destX = 0;
+    if (destX < dest->clipX1) {
+        w -= dest->clipX1 - destX;
+        srcX += dest->clipX1 - destX;
+        destX = dest->clipX1;
     }
-    if (destY < 0) {
-        h += destY;
-        srcY -= destY;
-        destY = 0;
+    if (destY < dest->clipY1) {
+        h -= dest->clipY1 - destY;
+        srcY += dest->clipY1 - destY;
+        destY = dest->clipY1;
     }
-    if (destX + w > dest->width) w = dest->width - destX;
-    if (destY + h > dest->height) h = dest->height - destY;
+    if (destX + w > dest->clipX2) w = dest->clipX2 - destX;
+    if (destY + h > dest->clipY2) h = dest->clipY2 - destY;
     
     if (w <= 0 || h <= 0) return;
     
@@ -599,6 +589,107 @@ void blitFramebuffer(Framebuffer* dest, int16_t destX, int16_t destY, Framebuffe
     }
 }
 
+// ============================================================================
+// Alpha blending - two RGB565 pixels per 32 bit word
+// ============================================================================
+
+// A word holding 2 pixels is split in 2 groups of channels that each have
+// at least 5 free bits above them, so multiplying by a 5 bit alpha can not
+// carry into the next channel:
+//   BLEND_MASK_A: blue0, red0, green1 (in place)
+//   BLEND_MASK_B: green0, blue1, red1 (after shifting the word right by 5)
+#define BLEND_MASK_A 0x07E0F81FUL
+#define BLEND_MASK_B 0x07C0F83FUL
+
+static inline uint32_t blendPair565(uint32_t f, uint32_t b, uint32_t alpha, uint32_t ialpha) {
+    uint32_t x = (((f & BLEND_MASK_A) * alpha + (b & BLEND_MASK_A) * ialpha) >> 5) & BLEND_MASK_A;
+    uint32_t y = (((f >> 5) & BLEND_MASK_B) * alpha + ((b >> 5) & BLEND_MASK_B) * ialpha) & (BLEND_MASK_B << 5);
+    return x | y;
+}
+
+// Blend count pixels: dest = fg * alpha + bg * (32 - alpha)
+// dest may be the same buffer as fg or bg
+void blendSpan565(uint16_t* dest, const uint16_t* fg, const uint16_t* bg, int32_t count, uint8_t alpha) {
+    if (!dest || !fg || !bg || count <= 0) return;
+    
+    // Nothing to blend at the extremes
+    if (alpha >= 32) {
+        if (dest != fg) memmove(dest, fg, count * sizeof(uint16_t));
+        return;
+    }
+    if (alpha == 0) {
+        if (dest != bg) memmove(dest, bg, count * sizeof(uint16_t));
+        return;
+    }
+    
+    uint32_t ialpha = 32 - alpha;
+    
+    // Word access needs all 3 pointers equally aligned, otherwise go pixel by pixel
+    if ((((uintptr_t)dest ^ (uintptr_t)fg) & 2) || (((uintptr_t)dest ^ (uintptr_t)bg) & 2)) {
+        while (count--) {
+            *dest++ = blend565(*fg++, *bg++, alpha);
+        }
+        return;
+    }
+    
+    if ((uintptr_t)dest & 2) {
+        *dest++ = blend565(*fg++, *bg++, alpha);
+        count--;
+    }
+    
+    uint32_t* d32 = (uint32_t*)dest;
+    const uint32_t* f32 = (const uint32_t*)fg;
+    const uint32_t* b32 = (const uint32_t*)bg;
+    int32_t pairs = count >> 1;
+    
+    while (pairs--) {
+        *d32++ = blendPair565(*f32++, *b32++, alpha, ialpha);
+    }
+    
+    if (count & 1) {
+        *(uint16_t*)d32 = blend565(*(const uint16_t*)f32, *(const uint16_t*)b32, alpha);
+    }
+}
+
+// Blend count pixels against a single color: dest = fg * alpha + color * (32 - alpha)
+// The color part is the same for every pixel so it is computed once
+void blendSpanColor565(uint16_t* dest, const uint16_t* fg, uint16_t color, int32_t count, uint8_t alpha) {
+    if (!dest || !fg || count <= 0) return;
+    if (alpha > 32) alpha = 32;
+    
+    uint32_t ialpha = 32 - alpha;
+    uint32_t c = color | ((uint32_t)color << 16);
+    uint32_t cA = (c & BLEND_MASK_A) * ialpha;
+    uint32_t cB = ((c >> 5) & BLEND_MASK_B) * ialpha;
+    
+    if (((uintptr_t)dest ^ (uintptr_t)fg) & 2) {
+        while (count--) {
+            *dest++ = blend565(*fg++, color, alpha);
+        }
+        return;
+    }
+    
+    if ((uintptr_t)dest & 2) {
+        *dest++ = blend565(*fg++, color, alpha);
+        count--;
+    }
+    
+    uint32_t* d32 = (uint32_t*)dest;
+    const uint32_t* f32 = (const uint32_t*)fg;
+    int32_t pairs = count >> 1;
+    
+    while (pairs--) {
+        uint32_t f = *f32++;
+        uint32_t x = (((f & BLEND_MASK_A) * alpha + cA) >> 5) & BLEND_MASK_A;
+        uint32_t y = (((f >> 5) & BLEND_MASK_B) * alpha + cB) & (BLEND_MASK_B << 5);
+        *d32++ = x | y;
+    }
+    
+    if (count & 1) {
+        *(uint16_t*)d32 = blend565(*(const uint16_t*)f32, color, alpha);
+    }
+}
+
 // ============================================================================
 // HIGHLY OPTIMIZED: Flexible RGB565 image drawing
 // ============================================================================
@@ -626,6 +717,9 @@ void bufferDrawImage(Framebuffer* fb, int16_t x, int16_t y, const uint8_t* image
                      uint8_t bgr, uint8_t littleEndian, uint8_t rle) {
     if (!fb || !fb->buffer || !image) return;
     
+    x += fb->originX;
+    y += fb->originY;
+    
     // Calculate clipping for destination
     int16_t srcX = 0;
     int16_t srcY = 0;
@@ -633,27 +727,27 @@ void bufferDrawImage(Framebuffer* fb, int16_t x, int16_t y, const uint8_t* image
     int16_t drawHeight = h;
     
     // Clip left
-    if (x < 0) {
-        srcX = -x;
-        drawWidth += x;
-        x = 0;
+    if (x < fb->clipX1) {
+        srcX = fb->clipX1 - x;
+        drawWidth -= srcX;
+        x = fb->clipX1;
     }
     
     // Clip top
-    if (y < 0) {
-        srcY = -y;
-        drawHeight += y;
-        y = 0;
+    if (y < fb->clipY1) {
+        srcY = fb->clipY1 - y;
+        drawHeight -= srcY;
+        y = fb->clipY1;
     }
     
     // Clip right
-    if (x + drawWidth > fb->width) {
-        drawWidth = fb->width - x;
+    if (x + drawWidth > fb->clipX2) {
+        drawWidth = fb->clipX2 - x;
     }
     
     // Clip bottom
-    if (y + drawHeight > fb->height) {
-        drawHeight = fb->height - y;
+    if (y + drawHeight > fb->clipY2) {
+        drawHeight = fb->clipY2 - y;
     }
     
     // Nothing to draw
@@ -952,6 +1046,9 @@ void bufferDrawImageTransparent(Framebuffer* fb, int16_t x, int16_t y, const uin
                                 uint8_t bgr, uint8_t littleEndian, uint8_t rle, uint16_t transparentColor) {
     if (!fb || !fb->buffer || !image) return;
     
+    x += fb->originX;
+    y += fb->originY;
+    
     // Calculate clipping for destination
     int16_t srcX = 0;
     int16_t srcY = 0;
@@ -959,27 +1056,27 @@ void bufferDrawImageTransparent(Framebuffer* fb, int16_t x, int16_t y, const uin
     int16_t drawHeight = h;
     
     // Clip left
-    if (x < 0) {
-        srcX = -x;
-        drawWidth += x;
-        x = 0;
+    if (x < fb->clipX1) {
+        srcX = fb->clipX1 - x;
+        drawWidth -= srcX;
+        x = fb->clipX1;
     }
     
     // Clip top
-    if (y < 0) {
-        srcY = -y;
-        drawHeight += y;
-        y = 0;
+    if (y < fb->clipY1) {
+        srcY = fb->clipY1 - y;
+        drawHeight -= srcY;
+        y = fb->clipY1;
     }
     
     // Clip right
-    if (x + drawWidth > fb->width) {
-        drawWidth = fb->width - x;
+    if (x + drawWidth > fb->clipX2) {
+        drawWidth = fb->clipX2 - x;
     }
     
     // Clip bottom
-    if (y + drawHeight > fb->height) {
-        drawHeight = fb->height - y;
+    if (y + drawHeight > fb->clipY2) {
+        drawHeight = fb->clipY2 - y;
     }
     
     // Nothing to draw
@@ -12,8 +12,22 @@ typedef struct {
     int16_t height;
     uint8_t littleEndian;  // 1=little-endian (default), 0=big-endian
     uint8_t bgr;           // 1=BGR format, 0=RGB format (default)
+    int16_t clipX1;        // clip rectangle in buffer coordinates, x2 / y2 exclusive
+    int16_t clipY1;        // drawing outside of it is skipped
+    int16_t clipX2;
+    int16_t clipY2;
+    int16_t originX;       // added to the coordinates of every primitive (sub views)
+    int16_t originY;
 } Framebuffer;
 
+// Rectangle, used for dirty / redraw areas
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+} FbRect;
+
 // Helper macros
 #ifndef _swap_int16_t
 #define _swap_int16_t(a, b) { int16_t t = a; a = b; b = t; }
@@ -31,6 +45,12 @@ typedef struct {
 #define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
 #endif
 
+// True when both rectangles overlap
+inline bool fbRectIntersects(const FbRect* a, const FbRect* b) {
+    return (a->x < b->x + b->w) && (b->x < a->x + a->w) &&
+           (a->y < b->y + b->h) && (b->y < a->y + a->h);
+}
+
 // Color conversion helper - returns RGB565 in CPU native endianness
 inline uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) {
     return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
@@ -41,12 +61,35 @@ inline uint16_t rgb565_be(uint8_t r, uint8_t g, uint8_t b) {
     return rgb565(r,g,b) >> 8 | rgb565(r,g,b) << 8;
 }
 
+// Blend two RGB565 pixels, alpha 0-32 (32 = only fg)
+// Spreads the pixel over 32 bits (green in the top half, red/blue in the bottom half)
+// so all 3 channels get blended with one multiply each
+inline uint16_t blend565(uint16_t fg, uint16_t bg, uint8_t alpha) {
+    uint32_t f = (fg | ((uint32_t)fg << 16)) & 0x07E0F81F;
+    uint32_t b = (bg | ((uint32_t)bg << 16)) & 0x07E0F81F;
+    uint32_t r = ((f * alpha + b * (32 - alpha)) >> 5) & 0x07E0F81F;
+    return (uint16_t)(r | (r >> 16));
+}
+
 // Function declarations
 // createFramebuffer: littleEndian=1 for LE (default), 0 for BE; bgr=1 for BGR, 0 for RGB (default)
 Framebuffer* createFramebuffer(int16_t width, int16_t height, uint8_t littleEndian, uint8_t bgr);
 void destroyFramebuffer(Framebuffer* fb);
 inline void clearFramebuffer(Framebuffer* fb, uint16_t color);
 
+// Clipping and sub views
+// All primitives below translate by the origin and are clipped to the clip rectangle,
+// a framebuffer not made with createFramebuffer needs bufferResetClip once it has its size.
+// Typical usage:
+//   FbRect panel = {240, 30, 80, 80};
+//   bufferSetViewport(&fb, &panel);   // (0,0) is now the top left of the panel
+//   ... draw ...
+//   bufferResetClip(&fb);
+void bufferResetClip(Framebuffer* fb);                                            // whole buffer, origin 0,0
+void bufferSetClip(Framebuffer* fb, int16_t x, int16_t y, int16_t w, int16_t h);   // buffer coordinates, origin not applied
+void bufferSetOrigin(Framebuffer* fb, int16_t x, int16_t y);
+void bufferSetViewport(Framebuffer* fb, const FbRect* view);                       // clip to view, origin at its top left
+
 // Basic drawing primitives (inlined for performance)
 inline void bufferDrawPixel(Framebuffer* fb, int16_t x, int16_t y, uint16_t color);
 inline void bufferFillRect(Framebuffer* fb, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
@@ -82,6 +125,10 @@ void bufferPrintFloat(Framebuffer* fb, int16_t x, int16_t y, float value, int de
 // Buffer to buffer blit with clipping
 void blitFramebuffer(Framebuffer* dest, int16_t destX, int16_t destY, Framebuffer* src, int16_t srcX, int16_t srcY, int16_t w, int16_t h);
 
+// Alpha blending (alpha 0-32, 32 = only fg), processes 2 pixels per 32 bit word
+void blendSpan565(uint16_t* dest, const uint16_t* fg, const uint16_t* bg, int32_t count, uint8_t alpha);
+void blendSpanColor565(uint16_t* dest, const uint16_t* fg, uint16_t color, int32_t count, uint8_t alpha);
+
 // ============================================================================
 // NEW: Flexible RGB565 image drawing with format options and RLE support
 // ============================================================================
@@ -160,7 +207,71 @@ inline void bufferDrawImageBGR565_BE_RLE(Framebuffer* fb, int16_t x, int16_t y,
 // INLINE FUNCTION IMPLEMENTATIONS (for performance)
 // ============================================================================
 
+// Unclipped inner routines: buffer coordinates (origin already applied) that must lie
+// inside the clip rectangle. Primitives clip once and then only call these.
+
+inline void bufferDrawPixelUnclipped(Framebuffer* fb, int16_t x, int16_t y, uint16_t color) {
+    fb->buffer[y * fb->width + x] = color;
+}
+
+inline void bufferDrawHSpanUnclipped(Framebuffer* fb, int16_t x, int16_t y, int16_t w, uint16_t color) {
+    uint16_t* ptr = fb->buffer + (y * fb->width + x);
+    while (w-- > 0) {
+        *ptr++ = color;
+    }
+}
+
+inline void bufferDrawVSpanUnclipped(Framebuffer* fb, int16_t x, int16_t y, int16_t h, uint16_t color) {
+    uint16_t* ptr = fb->buffer + (y * fb->width + x);
+    while (h-- > 0) {
+        *ptr = color;
+        ptr += fb->width;
+    }
+}
+
+inline void bufferFillRectUnclipped(Framebuffer* fb, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    uint16_t* ptr = fb->buffer + (y * fb->width + x);
+    int16_t rowSkip = fb->width - w;
+    
+    for (int16_t j = 0; j < h; j++) {
+        for (int16_t i = 0; i < w; i++) {
+            *ptr++ = color;
+        }
+        ptr += rowSkip;
+    }
+}
+
+// True when the rectangle (buffer coordinates) lies completely inside the clip rectangle
+inline bool bufferClipContains(const Framebuffer* fb, int16_t x, int16_t y, int16_t w, int16_t h) {
+    return (x >= fb->clipX1) && (y >= fb->clipY1) && (x + w <= fb->clipX2) && (y + h <= fb->clipY2);
+}
+
+// Clip a rectangle in buffer coordinates, false when nothing is left
+inline bool bufferClipRect(const Framebuffer* fb, int16_t* x, int16_t* y, int16_t* w, int16_t* h) {
+    if (*x < fb->clipX1) { *w -= fb->clipX1 - *x; *x = fb->clipX1; }
+    if (*y < fb->clipY1) { *h -= fb->clipY1 - *y; *y = fb->clipY1; }
+    if (*x + *w > fb->clipX2) *w = fb->clipX2 - *x;
+    if (*y + *h > fb->clipY2) *h = fb->clipY2 - *y;
+    return (*w > 0) && (*h > 0);
+}
+
+// Clipped spans in buffer coordinates
+inline void bufferDrawHSpanClipped(Framebuffer* fb, int16_t x, int16_t y, int16_t w, uint16_t color) {
+    if (y < fb->clipY1 || y >= fb->clipY2) return;
+    if (x < fb->clipX1) { w -= fb->clipX1 - x; x = fb->clipX1; }
+    if (x + w > fb->clipX2) w = fb->clipX2 - x;
+    if (w > 0) bufferDrawHSpanUnclipped(fb, x, y, w, color);
+}
+
+inline void bufferDrawVSpanClipped(Framebuffer* fb, int16_t x, int16_t y, int16_t h, uint16_t color) {
+    if (x < fb->clipX1 || x >= fb->clipX2) return;
+    if (y < fb->clipY1) { h -= fb->clipY1 - y; y = fb->clipY1; }
+    if (y + h > fb->clipY2) h = fb->clipY2 - y;
+    if (h > 0) bufferDrawVSpanUnclipped(fb, x, y, h, color);
+}
+
 // Clear framebuffer to a color (optimized with memset for black)
+// Always clears the whole buffer, clip rectangle and origin are ignored
 inline void clearFramebuffer(Framebuffer* fb, uint16_t color) {
     if (!fb || !fb->buffer) return;
     
@@ -178,113 +289,52 @@ inline void clearFramebuffer(Framebuffer* fb, uint16_t color) {
 // Draw a single pixel
 inline void bufferDrawPixel(Framebuffer* fb, int16_t x, int16_t y, uint16_t color) {
     if (!fb || !fb->buffer) return;
-    if (x >= 0 && x < fb->width && y >= 0 && y < fb->height) {
-        *(fb->buffer + y * fb->width + x) = color;
+    x += fb->originX;
+    y += fb->originY;
+    if (x >= fb->clipX1 && x < fb->clipX2 && y >= fb->clipY1 && y < fb->clipY2) {
+        bufferDrawPixelUnclipped(fb, x, y, color);
     }
 }
 
 // Fill a rectangle
 inline void bufferFillRect(Framebuffer* fb, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
     if (!fb || !fb->buffer) return;
-    
-    // Clip to screen bounds
-    if (x < 0) { w += x; x = 0; }
-    if (y < 0) { h += y; y = 0; }
-    if (x + w > fb->width) w = fb->width - x;
-    if (y + h > fb->height) h = fb->height - y;
-    if (w <= 0 || h <= 0) return;
-    
-    // Use pointer arithmetic
-    uint16_t* ptr = fb->buffer + (y * fb->width + x);
-    int16_t rowSkip = fb->width - w;
-    
-    for (int16_t j = 0; j < h; j++) {
-        for (int16_t i = 0; i < w; i++) {
-            *ptr++ = color;
-        }
-        ptr += rowSkip;
-    }
+    x += fb->originX;
+    y += fb->originY;
+    if (!bufferClipRect(fb, &x, &y, &w, &h)) return;
+    bufferFillRectUnclipped(fb, x, y, w, h, color);
 }
 
 // Draw a rectangle outline
 inline void bufferDrawRect(Framebuffer* fb, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
     if (!fb || !fb->buffer) return;
     if (w <= 0 || h <= 0) return;
+    x += fb->originX;
+    y += fb->originY;
     
-    // Top line
-    if (y >= 0 && y < fb->height) {
-        int16_t x1 = max(0, x);
-        int16_t x2 = min(fb->width, x + w);
-        uint16_t* ptr = fb->buffer + (y * fb->width + x1);
-        for (int16_t i = x1; i < x2; i++) {
-            *ptr++ = color;
-        }
-    }
-    
-    // Bottom line
-    int16_t by = y + h - 1;
-    if (by >= 0 && by < fb->height) {
-        int16_t x1 = max(0, x);
-        int16_t x2 = min(fb->width, x + w);
-        uint16_t* ptr = fb->buffer + (by * fb->width + x1);
-        for (int16_t i = x1; i < x2; i++) {
-            *ptr++ = color;
-        }
-    }
-    
-    // Left line
-    if (x >= 0 && x < fb->width) {
-        int16_t y1 = max(0, y);
-        int16_t y2 = min(fb->height, y + h);
-        uint16_t* ptr = fb->buffer + (y1 * fb->width + x);
-        for (int16_t j = y1; j < y2; j++) {
-            *ptr = color;
-            ptr += fb->width;
-        }
-    }
-    
-    // Right line
-    int16_t rx = x + w - 1;
-    if (rx >= 0 && rx < fb->width) {
-        int16_t y1 = max(0, y);
-        int16_t y2 = min(fb->height, y + h);
-        uint16_t* ptr = fb->buffer + (y1 * fb->width + rx);
-        for (int16_t j = y1; j < y2; j++) {
-            *ptr = color;
-            ptr += fb->width;
-        }
+    if (bufferClipContains(fb, x, y, w, h)) {
+        bufferDrawHSpanUnclipped(fb, x, y, w, color);
+        bufferDrawHSpanUnclipped(fb, x, y + h - 1, w, color);
+        bufferDrawVSpanUnclipped(fb, x, y, h, color);
+        bufferDrawVSpanUnclipped(fb, x + w - 1, y, h, color);
+    } else {
+        bufferDrawHSpanClipped(fb, x, y, w, color);
+        bufferDrawHSpanClipped(fb, x, y + h - 1, w, color);
+        bufferDrawVSpanClipped(fb, x, y, h, color);
+        bufferDrawVSpanClipped(fb, x + w - 1, y, h, color);
     }
 }
 
 // Draw a horizontal line
 inline void bufferDrawFastHLine(Framebuffer* fb, int16_t x, int16_t y, int16_t w, uint16_t color) {
     if (!fb || !fb->buffer) return;
-    if (y < 0 || y >= fb->height || w <= 0) return;
-    
-    if (x < 0) { w += x; x = 0; }
-    if (x + w > fb->width) w = fb->width - x;
-    if (w <= 0) return;
-    
-    uint16_t* ptr = fb->buffer + (y * fb->width + x);
-    for (int16_t i = 0; i < w; i++) {
-        *ptr++ = color;
-    }
+    bufferDrawHSpanClipped(fb, x + fb->originX, y + fb->originY, w, color);
 }
 
 // Draw a vertical line
 inline void bufferDrawFastVLine(Framebuffer* fb, int16_t x, int16_t y, int16_t h, uint16_t color) {
     if (!fb || !fb->buffer) return;
-    if (x < 0 || x >= fb->width || h <= 0) return;
-    
-    if (y < 0) { h += y; y = 0; }
-    if (y + h > fb->height) h = fb->height - y;
-    if (h <= 0) return;
-    
-    uint16_t* ptr = fb->buffer + (y * fb->width + x);
-    for (int16_t i = 0; i < h; i++) {
-        *ptr = color;
-        ptr += fb->width;
-    }
+    bufferDrawVSpanClipped(fb, x + fb->originX, y + fb->originY, h, color);
 }
 
 #endif // FRAMEBUFFER_H
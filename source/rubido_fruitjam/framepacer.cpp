@@ -0,0 +1,88 @@
+// framepacer.cpp - frame scheduler for the main loop
+// Sleeps the core with WFE until the next frame deadline (a hardware alarm wakes it up)
+// and keeps track if a new frame needs to be rendered at all
+
+#include "framepacer.h"
+#include <pico/time.h>
+
+static uint32_t frame_period_us = 1000000 / 60;
+static uint16_t target_fps = 60;
+static absolute_time_t next_frame_time;
+static absolute_time_t last_frame_time;
+static uint32_t frame_time_us = 0;
+static uint32_t sleep_time_us = 0;
+static uint32_t skipped_frames = 0;
+static bool dirty = true;
+
+void framePacerInit(uint16_t fps) {
+    framePacerSetTargetFps(fps);
+    last_frame_time = get_absolute_time();
+    next_frame_time = delayed_by_us(last_frame_time, frame_period_us);
+    dirty = true;
+}
+
+void framePacerSetTargetFps(uint16_t fps) {
+    if (fps == 0) fps = 1;
+    target_fps = fps;
+    frame_period_us = 1000000 / fps;
+}
+
+uint16_t framePacerGetTargetFps() {
+    return target_fps;
+}
+
+// Sleep until the next frame is due. The core wakes up on every interrupt (the I2S
+// DMA finishing a buffer, the frame alarm) and runs idleTask each time it does
+void framePacerWaitForFrame(framePacerIdleTask idleTask) {
+    uint32_t slept = 0;
+
+    if (idleTask) idleTask();
+
+    while (!time_reached(next_frame_time)) {
+        absolute_time_t before = get_absolute_time();
+        best_effort_wfe_or_timeout(next_frame_time);
+        slept += (uint32_t)absolute_time_diff_us(before, get_absolute_time());
+        if (idleTask) idleTask();
+    }
+
+    absolute_time_t now = get_absolute_time();
+    frame_time_us = (uint32_t)absolute_time_diff_us(last_frame_time, now);
+    sleep_time_us = slept;
+    last_frame_time = now;
+
+    // Schedule from the previous deadline so the rate does not drift,
+    // but resync when we fell more than a frame behind
+    next_frame_time = delayed_by_us(next_frame_time, frame_period_us);
+    if (absolute_time_diff_us(now, next_frame_time) < 0)
+        next_frame_time = delayed_by_us(now, frame_period_us);
+}
+
+void framePacerMarkDirty() {
+    dirty = true;
+}
+
+// Returns true when something requested a new frame since the last render
+// and clears the request, scenes can call framePacerMarkDirty() while drawing
+// to ask for the next frame as well (animations)
+bool framePacerBeginRender() {
+    if (!dirty) {
+        skipped_frames++;
+        return false;
+    }
+    dirty = false;
+    return true;
+}
+
+uint32_t framePacerGetFrameTime() {
+    return frame_time_us;
+}
+
+uint8_t framePacerGetIdlePercent() {
+    if (frame_time_us == 0) return 0;
+    uint32_t percent = (sleep_time_us * 100) / frame_time_us;
+    return percent > 100 ? 100 : percent;
+}
+
+uint32_t framePacerGetSkippedFrames() {
+    return skipped_frames;
+}
@@ -0,0 +1,35 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <stdint.h>
+
+// Frame pacing: sleeps the core between frames instead of busy polling micros()
+// and lets the main loop skip rendering when nothing on screen changed.
+// Typical usage:
+//   void loop() {
+//     framePacerWaitForFrame(updateI2SAudio);  // sleeps, runs updateI2SAudio() on every wake up
+//     // ... poll input, call framePacerMarkDirty() when something changed ...
+//     if (!framePacerBeginRender())
+//       return;                                // nothing changed, keep showing the last frame
+//     // ... draw and swap ...
+//   }
+
+typedef void (*framePacerIdleTask)(void);
+
+// Setup function
+void framePacerInit(uint16_t fps);
+
+// Core functions
+void framePacerWaitForFrame(framePacerIdleTask idleTask);
+void framePacerMarkDirty();
+bool framePacerBeginRender();
+
+// Per scene frame rate
+void framePacerSetTargetFps(uint16_t fps);
+uint16_t framePacerGetTargetFps();
+
+// Query functions
+uint32_t framePacerGetFrameTime();      // Time in us between the last two frame ticks
+uint8_t framePacerGetIdlePercent();     // Part of the last frame the core spent sleeping
+uint32_t framePacerGetSkippedFrames();  // Frame ticks where rendering was skipped
+#endif
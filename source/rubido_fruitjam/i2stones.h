@@ -2,16 +2,23 @@
 #define I2STONES_H
 
 #include <stdint.h>
-
-// Configuration
-#ifndef MAX_CHANNELS
-#define MAX_CHANNELS 64
-#endif
+#include <stddef.h>
+#include "audiomixer.h"   // MAX_CHANNELS, block size
+#include "tones.h"        // playTone and the rest of the tone api
 
 // Debug configuration
 // Uncomment to enable diagnostic output every 5 seconds:
 //#define I2STONES_DEBUG
 
+// Headphone detection configuration
+#ifndef HEADPHONE_POLL_MS
+#define HEADPHONE_POLL_MS 100          // jack status read this often
+#endif
+#ifndef HEADPHONE_DEBOUNCE_POLLS
+#define HEADPHONE_DEBOUNCE_POLLS 3     // polls a new state has to hold
+#endif
+#define HEADPHONE_EVENT_QUEUE_SIZE 8
+
 // Audio output modes
 enum AudioOutputMode {
     AUDIO_OUT_HEADPHONES_ONLY,   // Only output to headphone jack
@@ -20,49 +27,54 @@ enum AudioOutputMode {
     AUDIO_OUT_AUTO_DETECT        // Auto-switch: headphones when plugged, speaker when not
 };
 
-// CRITICAL: Call updateI2SAudio() in your main loop to handle scheduled tones
-// Audio generation happens automatically via timer interrupt (just like mixedtones)
+// Debounced headphone plug / unplug, see getHeadphoneEvent()
+struct HeadphoneEvent {
+    bool plugged;
+    uint32_t time_ms;           // millis() when the change was accepted
+};
+
+// Call updateI2SAudio() in your main loop for diagnostics, it never touches the codec
+// Audio generation happens automatically: the I2S transmit callback pulls mixer blocks
+// Tone functions queue a command for the mixer, it applies them at the next block
+// Call serviceI2SAudioControl() regularly from a background context that isn't the
+// game loop (the other core's loop). After setup it is the only code that talks to
+// the codec over I2C: it polls the jack every HEADPHONE_POLL_MS, debounces it,
+// switches outputs in AUDIO_OUT_AUTO_DETECT mode and applies setAudioOutput().
 // Typical usage:
 //   void loop() {
-//     updateI2SAudio();  // Activates scheduled tones
+//     updateI2SAudio();
+//     HeadphoneEvent event;
+//     while (getHeadphoneEvent(&event)) { ... }
 //     // ... rest of your code - audio plays automatically!
 //   }
+//   void loop1() {
+//     serviceI2SAudioControl();
+//   }
 
 // Setup function
 bool setupI2SAudio(uint32_t sample_rate = 44100, AudioOutputMode output_mode = AUDIO_OUT_BOTH, uint32_t buffer_size_bytes = 32768);
 
 // Core functions
 void updateI2SAudio();
-int8_t playTone(float frequency, uint8_t volume, float duration_sec = 0, float delay_sec = 0);
-int8_t playToneOnChannel(uint8_t channel, float frequency, uint8_t volume, float duration_sec = 0, float delay_sec = 0);
-void stopChannel(int8_t channel);
-void stopAllTones();
-void cancelScheduled(int8_t channel);
+void serviceI2SAudioControl();   // background context only
 
-// Query functions
-uint8_t getMaxChannels();
-int8_t findFreeChannel();
-bool isChannelActive(int8_t channel);
-uint8_t getActiveChannelCount();
-uint8_t getPlayingChannelCount();
+// Query functions (the voice queries are in tones.h)
 uint32_t getAudioStartTime();
 uint32_t getSampleRate();
 uint8_t getBitDepth();
-uint32_t getTimerCallCount();  // Debug: check if timer is firing
-uint32_t getBufferSkipCount();  // Debug: check buffer overruns
-uint32_t getBufferUnderrunCount();  // Debug: check buffer underruns
-uint32_t getRecoveryWriteCount();  // Debug: check recovery attempts
-uint32_t getBufferUnderrunCount();  // Debug: check buffer underruns
-uint32_t getRecoveryWriteCount();  // Debug: check recovery attempts
+uint32_t getTransmitCallCount();  // Debug: check if the I2S callback is firing
 
-// Output control functions
-bool isHeadphonePluggedIn();
-void setAudioOutput(AudioOutputMode mode);
+// Output control functions, none of them wait on I2C
+bool isHeadphonePluggedIn();                      // debounced state
+bool getHeadphoneEvent(HeadphoneEvent* event);    // next plug / unplug, false when none
+void setAudioOutput(AudioOutputMode mode);        // applied by serviceI2SAudioControl()
 AudioOutputMode getAudioOutputMode();
 
 // Diagnostic functions
-void printI2SAudioDiagnostics();   // Print buffer health, skip rate, etc
-void resetI2SAudioDiagnostics();   // Reset diagnostic counters
+void printI2SAudioDiagnostics();   // Print callback count, buffer fill, etc
+void resetI2SAudioDiagnostics();   // Reset diagnostic counters and timing
+void getI2SAudioTiming(AudioTimingStats* stats);  // start latency, block cost, buffer fill histogram
+void resetI2SAudioTiming();
 uint32_t getActualBufferSize();     // Get actual I2S buffer size
 uint32_t getBufferAvailable();      // Get available buffer space
 #endif
@@ -0,0 +1,61 @@
+// inputlatency.cpp - input to photon latency per input device
+// Keeps the latest samples per device in a ring, the percentiles are only
+// worked out (sorting a copy) when someone asks, the debug overlay once a frame.
+
+#include "inputlatency.h"
+
+static uint32_t pending_us[INPUT_DEVICE_COUNT];
+static bool pending[INPUT_DEVICE_COUNT];
+static uint32_t samples[INPUT_DEVICE_COUNT][INPUT_LATENCY_SAMPLES];
+static uint32_t sample_count[INPUT_DEVICE_COUNT];
+
+void inputLatencyMark(uint8_t device, uint32_t pressed_us) {
+    if (device >= INPUT_DEVICE_COUNT) return;
+    // the earliest press a frame shows is the one that waited longest
+    if (pending[device] && (int32_t)(pressed_us - pending_us[device]) >= 0) return;
+    pending_us[device] = pressed_us;
+    pending[device] = true;
+}
+
+void inputLatencyFrameShown(uint32_t now_us) {
+    for (int device = 0; device < INPUT_DEVICE_COUNT; device++) {
+        if (!pending[device]) continue;
+        pending[device] = false;
+        samples[device][sample_count[device] % INPUT_LATENCY_SAMPLES] = now_us - pending_us[device];
+        sample_count[device]++;
+    }
+}
+
+bool inputLatencyGetPercentiles(uint8_t device, uint32_t* p50_us, uint32_t* p99_us) {
+    if (device >= INPUT_DEVICE_COUNT || sample_count[device] == 0) return false;
+    uint32_t count = sample_count[device] < INPUT_LATENCY_SAMPLES ? sample_count[device] : INPUT_LATENCY_SAMPLES;
+
+    // insertion sort, at most about 8000 compares for 128 samples
+    uint32_t sorted[INPUT_LATENCY_SAMPLES];
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t value = samples[device][i];
+        uint32_t j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+
+    // nearest rank
+    *p50_us = sorted[(count * 50 + 99) / 100 - 1];
+    *p99_us = sorted[(count * 99 + 99) / 100 - 1];
+    return true;
+}
+
+uint32_t inputLatencyGetCount(uint8_t device) {
+    if (device >= INPUT_DEVICE_COUNT) return 0;
+    return sample_count[device];
+}
+
+void inputLatencyReset() {
+    for (int device = 0; device < INPUT_DEVICE_COUNT; device++) {
+        pending[device] = false;
+        sample_count[device] = 0;
+    }
+}
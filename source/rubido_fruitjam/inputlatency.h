@@ -0,0 +1,41 @@
+#ifndef INPUTLATENCY_H
+#define INPUTLATENCY_H
+
+#include <stdint.h>
+
+// Configuration
+#ifndef INPUT_LATENCY_SAMPLES
+#define INPUT_LATENCY_SAMPLES 128   // latest presses kept per device for the percentiles
+#endif
+
+// Input to photon latency: from the moment a press reached the game (the USB report
+// callback on core1, the button poll on core0) to the swap of the first frame drawn
+// after the main loop picked it up. Only presses are measured, releases rarely
+// change the picture. A frame that is skipped because nothing changed keeps the
+// press pending for the next swap, so the time spent waiting for a frame counts.
+// Typical usage (main loop):
+//   updateUSBHButtons();
+//   uint32_t pressed_us;
+//   if (usbhGetKeyboardPressTime(&pressed_us)) inputLatencyMark(INPUT_DEVICE_KEYBOARD, pressed_us);
+//   ... render ...
+//   tft.swap();
+//   inputLatencyFrameShown(micros());
+// Times are micros(), which both cores share.
+
+enum InputDevice {
+    INPUT_DEVICE_KEYBOARD,
+    INPUT_DEVICE_GAMEPAD,
+    INPUT_DEVICE_BUTTONS,       // the buttons on the board
+    INPUT_DEVICE_COUNT
+};
+
+// A press the current frame consumed, the earliest one per device counts
+void inputLatencyMark(uint8_t device, uint32_t pressed_us);
+// Call right after the swap, measures every pending press
+void inputLatencyFrameShown(uint32_t now_us);
+
+// Percentiles over the latest INPUT_LATENCY_SAMPLES presses, false when there are none
+bool inputLatencyGetPercentiles(uint8_t device, uint32_t* p50_us, uint32_t* p99_us);
+uint32_t inputLatencyGetCount(uint8_t device);   // presses measured since the start
+void inputLatencyReset();
+#endif
@@ -0,0 +1,45 @@
+// Generated from: title.txt by tools/music/mkmusic.py
+
+#ifndef MUSICDATA_H
+#define MUSICDATA_H
+
+#include <stdint.h>
+#include "musicplayer.h"
+
+// title: 4 patterns of 16 rows, 324 bytes of pattern data
+static const uint8_t music_title_orders[] = { 0, 1, 2, 3 };
+static const uint16_t music_title_patterns[] = { 0, 82, 162, 244 };
+static const uint8_t music_title_pattern_data[] = {
+    0x03, 0x2D, 0x01, 0x03, 0x4C, 0x02, 0x0B, 0x45, 0x03, 0x00, 0x37, 0x00, 0x00, 0x00, 0x00, 0x08,
+    0x04, 0x42, 0x00, 0x00, 0x00, 0x00, 0x03, 0x39, 0x01, 0x03, 0x48, 0x02, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x03, 0x4A, 0x02, 0x00, 0x00, 0x00, 0x01, 0xFF, 0x03, 0x29, 0x01, 0x03, 0x4D, 0x02, 0x0B,
+    0x41, 0x03, 0x00, 0x47, 0x00, 0x00, 0x00, 0x00, 0x08, 0x04, 0x42, 0x00, 0x00, 0x00, 0x00, 0x03,
+    0x35, 0x01, 0x03, 0x4C, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x48, 0x02, 0x00, 0x00, 0x00,
+    0x01, 0xFF, 0x03, 0x30, 0x01, 0x03, 0x4C, 0x02, 0x0B, 0x48, 0x03, 0x00, 0x47, 0x00, 0x00, 0x00,
+    0x00, 0x08, 0x04, 0x42, 0x00, 0x00, 0x00, 0x00, 0x03, 0x3C, 0x01, 0x03, 0x4F, 0x02, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x03, 0x4C, 0x02, 0x00, 0x00, 0x00, 0x01, 0xFF, 0x03, 0x2B, 0x01, 0x03, 0x4A,
+    0x02, 0x0B, 0x43, 0x03, 0x00, 0x47, 0x00, 0x00, 0x00, 0x00, 0x08, 0x04, 0x42, 0x00, 0x00, 0x00,
+    0x00, 0x03, 0x37, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x47, 0x02, 0x00, 0x00, 0x00,
+    0x01, 0xFF, 0x03, 0x32, 0x01, 0x03, 0x4D, 0x02, 0x0B, 0x4A, 0x03, 0x00, 0x37, 0x00, 0x00, 0x00,
+    0x00, 0x08, 0x04, 0x42, 0x00, 0x00, 0x00, 0x00, 0x03, 0x3E, 0x01, 0x03, 0x4C, 0x02, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x03, 0x4A, 0x02, 0x00, 0x00, 0x00, 0x01, 0xFF, 0x03, 0x28, 0x01, 0x03, 0x44,
+    0x02, 0x0B, 0x40, 0x03, 0x00, 0x47, 0x00, 0x00, 0x00, 0x00, 0x08, 0x04, 0x42, 0x00, 0x00, 0x00,
+    0x00, 0x03, 0x34, 0x01, 0x03, 0x47, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x0A, 0x02, 0x00,
+    0x00, 0x00, 0x01, 0xFF, 0x03, 0x2D, 0x01, 0x03, 0x45, 0x02, 0x0B, 0x45, 0x03, 0x00, 0x37, 0x00,
+    0x00, 0x00, 0x00, 0x08, 0x04, 0x42, 0x00, 0x00, 0x00, 0x00, 0x03, 0x39, 0x01, 0x03, 0x48, 0x02,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xFF, 0x03, 0x2B, 0x01, 0x03, 0x47,
+    0x02, 0x0B, 0x43, 0x03, 0x00, 0x47, 0x00, 0x00, 0x00, 0x00, 0x08, 0x04, 0x42, 0x00, 0x00, 0x00,
+    0x00, 0x03, 0x37, 0x01, 0x03, 0x4A, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xFF,
+    0x01, 0xFF, 0x01, 0xFF,
+};
+static const MusicInstrument music_title_instruments[] = {
+    { 2, 48, { 2, 80, 200, 60 } },   // bass
+    { 1, 20, { 6, 90, 170, 120 } },   // lead
+    { 0, 26, { 2, 40, 150, 50 } },   // arp
+};
+static const MusicSong music_title = {
+    3, 16, 6, 100, 4, 0, 3,
+    music_title_orders, music_title_patterns, music_title_pattern_data, music_title_instruments
+};
+
+#endif
@@ -0,0 +1,319 @@
+// musicplayer.cpp - tracker style music, played from the mixer block hook
+// Everything below the game thread section runs in the audio interrupt
+
+#include "musicplayer.h"
+#include "notetables.h"
+#include <stddef.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#define MUSIC_CYCLES() rp2040.getCycleCount()
+#else
+#include <time.h>
+static uint32_t hostNanoseconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+#define MUSIC_CYCLES() hostNanoseconds()
+#endif
+
+#define MUSIC_MAX_VOLUME 64
+#define MUSIC_NO_EFFECT 0xFF
+#define MUSIC_MAX_PITCH (127 * 16)
+
+enum MusicCommand {
+    MUSIC_CMD_NONE,
+    MUSIC_CMD_PLAY,
+    MUSIC_CMD_STOP
+};
+
+struct MusicChannel {
+    uint8_t voice;
+    uint8_t instrument;         // index, 0xFF before the first one
+    int16_t pitch;              // 1/16 semitones, MIDI note * 16
+    int16_t pitch_offset;       // arpeggio / vibrato, this tick only
+    int8_t volume;              // 0-64
+    uint8_t effect;
+    uint8_t param;
+    uint8_t vibrato_pos;
+};
+
+// Game thread, handed over through music_command
+static uint8_t music_voices[MUSIC_MAX_CHANNELS];
+static uint8_t music_voice_count = 0;
+static const MusicSong* pending_song = NULL;
+static uint8_t music_command = MUSIC_CMD_NONE;
+static volatile uint8_t music_volume = 255;
+static volatile bool music_playing = false;
+
+// Audio interrupt only
+static const MusicSong* song = NULL;
+static MusicChannel channels[MUSIC_MAX_CHANNELS];
+static uint8_t order;
+static uint8_t row;
+static uint8_t tick;
+static uint8_t speed;
+static const uint8_t* row_data;       // next row to read
+static int16_t jump_order;            // -1 or order to go to after this row
+static uint8_t jump_row;
+static uint32_t tick_samples_q8;      // tick length in samples, 8 bit fraction
+static uint32_t tick_countdown_q8;    // samples until the next tick
+
+// Cost statistics, written by the hook
+static volatile uint32_t block_cycles_avg = 0;
+static volatile uint32_t block_cycles_max = 0;
+
+// Vibrato, one cycle in 32 steps
+static const int8_t vibrato_table[32] = {
+    0, 12, 24, 35, 45, 53, 59, 63, 64, 63, 59, 53, 45, 35, 24, 12,
+    0, -12, -24, -35, -45, -53, -59, -63, -64, -63, -59, -53, -45, -35, -24, -12
+};
+
+// ============================================================================
+// Pattern data
+// ============================================================================
+
+static inline uint8_t cellSize(uint8_t flags) {
+    return 1 + ((flags & MUSIC_CELL_NOTE) ? 1 : 0) + ((flags & MUSIC_CELL_INSTRUMENT) ? 1 : 0) +
+           ((flags & MUSIC_CELL_VOLUME) ? 1 : 0) + ((flags & MUSIC_CELL_EFFECT) ? 2 : 0);
+}
+
+// Points row_data at row r of the pattern of order o, rows are packed so
+// the ones before it are skipped (only happens after a pattern break)
+static void seekRow(uint8_t o, uint8_t r) {
+    order = o < song->order_count ? o : song->restart;
+    row = r < song->rows ? r : 0;
+    const uint8_t* data = song->pattern_data + song->patterns[song->orders[order]];
+    for (uint16_t i = 0; i < (uint16_t)row * song->channels; i++) {
+        data += cellSize(*data);
+    }
+    row_data = data;
+}
+
+static void setTempo(uint8_t tempo) {
+    // a tick is 2.5 / tempo seconds, never shorter than a block at the lowest tempo of 32
+    if (tempo < 32) tempo = 32;
+    tick_samples_q8 = (uint32_t)(((uint64_t)audioMixerGetSampleRate() * 5 * 256) / (2 * tempo));
+}
+
+// ============================================================================
+// Channels
+// ============================================================================
+
+static uint32_t pitchIncrement(int32_t pitch) {
+    if (pitch < 0) pitch = 0;
+    if (pitch > MUSIC_MAX_PITCH) pitch = MUSIC_MAX_PITCH;
+    uint8_t note = pitch >> 4;
+    uint32_t a = toneNoteIncrement(note);
+    if ((pitch & 15) == 0) return a;
+    uint32_t b = toneNoteIncrement(note + 1);
+    return a + (((b - a) * (uint32_t)(pitch & 15)) >> 4);
+}
+
+static inline uint16_t channelAmplitude(const MusicChannel* ch) {
+    return (uint16_t)((ch->volume * music_volume) / MUSIC_MAX_VOLUME);
+}
+
+static void startNote(MusicChannel* ch, uint8_t note, uint32_t offset) {
+    if (ch->instrument >= song->instrument_count) return;
+    const MusicInstrument* inst = &song->instruments[ch->instrument];
+    ch->pitch = note * 16;
+    ch->vibrato_pos = 0;
+    AudioVoiceParams params;
+    params.phase_increment = pitchIncrement(ch->pitch);
+    params.duration_samples = 0;
+    params.amplitude = channelAmplitude(ch);
+    params.waveform = inst->waveform;
+    params.envelope = inst->envelope;
+    params.pan = 0;
+    audioMixerHookStartVoice(ch->voice, &params, offset);
+}
+
+static void readRow(uint32_t offset) {
+    const uint8_t* data = row_data;
+    for (uint8_t c = 0; c < song->channels; c++) {
+        MusicChannel* ch = &channels[c];
+        uint8_t flags = *data++;
+        uint8_t note = 0;
+        if (flags & MUSIC_CELL_NOTE) note = *data++;
+        if (flags & MUSIC_CELL_INSTRUMENT) {
+            ch->instrument = *data++ - 1;
+            if (ch->instrument < song->instrument_count) ch->volume = song->instruments[ch->instrument].volume;
+        }
+        if (flags & MUSIC_CELL_VOLUME) ch->volume = *data++;
+        ch->effect = MUSIC_NO_EFFECT;
+        if (flags & MUSIC_CELL_EFFECT) {
+            ch->effect = *data++;
+            ch->param = *data++;
+        }
+
+        if (flags & MUSIC_CELL_NOTE) {
+            if (note == MUSIC_NOTE_OFF) audioMixerHookStopVoice(ch->voice);
+            else startNote(ch, note, offset);
+        }
+
+        // Effects that act once on the row
+        switch (ch->effect) {
+            case 0xB: jump_order = ch->param; jump_row = 0; break;
+            case 0xC: ch->volume = ch->param > MUSIC_MAX_VOLUME ? MUSIC_MAX_VOLUME : ch->param; break;
+            case 0xD: if (jump_order < 0) jump_order = order + 1; jump_row = ch->param; break;
+            case 0xF:
+                if (ch->param >= 32) setTempo(ch->param);
+                else if (ch->param > 0) speed = ch->param;
+                break;
+        }
+        if (ch->volume > MUSIC_MAX_VOLUME) ch->volume = MUSIC_MAX_VOLUME;
+    }
+    row_data = data;
+}
+
+// Effects that act on every tick after the first of a row
+static void tickEffects(MusicChannel* ch) {
+    uint8_t x = ch->param >> 4;
+    uint8_t y = ch->param & 0x0F;
+    switch (ch->effect) {
+        case 0x0: {
+            uint8_t step = tick % 3;
+            ch->pitch_offset = (step == 1 ? x : step == 2 ? y : 0) * 16;
+            break;
+        }
+        case 0x1:
+            ch->pitch += ch->param;
+            if (ch->pitch > MUSIC_MAX_PITCH) ch->pitch = MUSIC_MAX_PITCH;
+            break;
+        case 0x2:
+            ch->pitch -= ch->param;
+            if (ch->pitch < 0) ch->pitch = 0;
+            break;
+        case 0x4:
+            ch->vibrato_pos += x;
+            ch->pitch_offset = (vibrato_table[ch->vibrato_pos & 31] * y) >> 4;
+            break;
+        case 0xA:
+            ch->volume += x ? x : -y;
+            if (ch->volume < 0) ch->volume = 0;
+            if (ch->volume > MUSIC_MAX_VOLUME) ch->volume = MUSIC_MAX_VOLUME;
+            break;
+    }
+}
+
+static void processTick(uint32_t offset) {
+    if (tick == 0) readRow(offset);
+    for (uint8_t c = 0; c < song->channels; c++) {
+        MusicChannel* ch = &channels[c];
+        ch->pitch_offset = 0;
+        if (tick != 0) tickEffects(ch);
+        audioMixerHookSetVoicePitch(ch->voice, pitchIncrement(ch->pitch + ch->pitch_offset));
+        audioMixerHookSetVoiceVolume(ch->voice, channelAmplitude(ch));
+    }
+
+    if (++tick < speed) return;
+    tick = 0;
+    if (jump_order >= 0) {
+        seekRow(jump_order, jump_row);
+        jump_order = -1;
+    } else if (++row >= song->rows) {
+        seekRow(order + 1, 0);
+    }
+}
+
+static void startSong(const MusicSong* new_song) {
+    song = new_song;
+    for (uint8_t c = 0; c < song->channels; c++) {
+        MusicChannel* ch = &channels[c];
+        ch->voice = music_voices[c];
+        ch->instrument = 0xFF;
+        ch->pitch = 60 * 16;
+        ch->pitch_offset = 0;
+        ch->volume = MUSIC_MAX_VOLUME;
+        ch->effect = MUSIC_NO_EFFECT;
+        ch->param = 0;
+        ch->vibrato_pos = 0;
+    }
+    tick = 0;
+    speed = song->speed ? song->speed : 6;
+    jump_order = -1;
+    setTempo(song->tempo);
+    tick_countdown_q8 = 0;
+    seekRow(0, 0);
+}
+
+static void stopSong() {
+    if (!song) return;
+    for (uint8_t c = 0; c < song->channels; c++) {
+        audioMixerHookStopVoice(channels[c].voice);
+    }
+    song = NULL;
+}
+
+static void musicBlockHook(uint32_t block_start_sample, uint32_t frames) {
+    (void)block_start_sample;
+    uint32_t start = MUSIC_CYCLES();
+
+    uint8_t command = __atomic_exchange_n(&music_command, (uint8_t)MUSIC_CMD_NONE, __ATOMIC_ACQUIRE);
+    if (command == MUSIC_CMD_STOP) {
+        stopSong();
+    } else if (command == MUSIC_CMD_PLAY) {
+        stopSong();
+        startSong(pending_song);
+    }
+    if (!song) return;
+
+    // Ticks that fall inside this block start at their own sample
+    uint32_t frames_q8 = frames << 8;
+    while (tick_countdown_q8 < frames_q8) {
+        processTick(tick_countdown_q8 >> 8);
+        tick_countdown_q8 += tick_samples_q8;
+    }
+    tick_countdown_q8 -= frames_q8;
+
+    uint32_t cycles = MUSIC_CYCLES() - start;
+    uint32_t avg = block_cycles_avg;
+    block_cycles_avg = avg + (int32_t)(cycles - avg) / 64;
+    if (cycles > block_cycles_max) block_cycles_max = cycles;
+}
+
+// ============================================================================
+// Game thread
+// ============================================================================
+
+bool musicPlay(const MusicSong* new_song) {
+    if (!new_song || new_song->channels == 0 || new_song->channels > MUSIC_MAX_CHANNELS) return false;
+    // Voices stay reserved once taken, the player may still be releasing notes on them
+    while (music_voice_count < new_song->channels) {
+        int8_t voice = audioMixerFindFreeVoice();
+        if (voice < 0) return false;
+        audioMixerReserveVoice(voice, true);
+        music_voices[music_voice_count++] = voice;
+    }
+    pending_song = new_song;
+    block_cycles_avg = 0;
+    block_cycles_max = 0;
+    audioMixerSetBlockHook(musicBlockHook);
+    __atomic_store_n(&music_command, (uint8_t)MUSIC_CMD_PLAY, __ATOMIC_RELEASE);
+    music_playing = true;
+    return true;
+}
+
+void musicStop() {
+    if (!music_playing) return;
+    __atomic_store_n(&music_command, (uint8_t)MUSIC_CMD_STOP, __ATOMIC_RELEASE);
+    music_playing = false;
+}
+
+bool musicIsPlaying() {
+    return music_playing;
+}
+
+void musicSetVolume(uint8_t volume) {
+    music_volume = volume;
+}
+
+uint32_t musicGetBlockCycles() {
+    return block_cycles_avg;
+}
+
+uint32_t musicGetMaxBlockCycles() {
+    return block_cycles_max;
+}
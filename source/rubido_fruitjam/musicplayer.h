@@ -0,0 +1,66 @@
+#ifndef MUSICPLAYER_H
+#define MUSICPLAYER_H
+
+#include <stdint.h>
+#include "audiomixer.h"
+
+// Configuration
+#ifndef MUSIC_MAX_CHANNELS
+#define MUSIC_MAX_CHANNELS 4
+#endif
+
+// Tracker style music player. Songs are an order list of patterns, a pattern is
+// rows of one cell per channel (note, instrument, volume, effect), packed and read
+// straight from flash a row at a time, nothing is unpacked into RAM.
+// The player runs as the mixer block hook: it works out the ticks that fall in each
+// block and starts notes at their exact sample on voices it reserved when the song
+// started, so sound effects keep their own voices and their latency.
+// A block does at most one tick (ticks are longer than a block for any tempo),
+// so the cost per block is bounded by one row of MUSIC_MAX_CHANNELS cells.
+// Typical usage:
+//   musicPlay(&music_title);       // generated by tools/music/mkmusic.py
+//   musicSetVolume(volume);
+//   musicStop();
+//
+// Effects (hex parameter xy / xx, as in MOD files):
+//   0xy arpeggio, 1xx slide up, 2xx slide down (1/16 semitones per tick),
+//   4xy vibrato (speed x, depth y), Axy volume slide, Bxx jump to order xx,
+//   Cxx set volume, Dxx break to row xx of the next order, Fxx speed (< 32) or tempo
+
+// Packed cell: a flags byte, then the fields it flags in this order
+#define MUSIC_CELL_NOTE 0x01        // MIDI note, MUSIC_NOTE_OFF releases
+#define MUSIC_CELL_INSTRUMENT 0x02  // instrument number, 1 based
+#define MUSIC_CELL_VOLUME 0x04      // 0-64
+#define MUSIC_CELL_EFFECT 0x08      // effect, parameter
+#define MUSIC_NOTE_OFF 0xFF
+
+struct MusicInstrument {
+    uint8_t waveform;           // AudioWaveform
+    uint8_t volume;             // 0-64
+    AudioEnvelope envelope;
+};
+
+struct MusicSong {
+    uint8_t channels;           // up to MUSIC_MAX_CHANNELS
+    uint8_t rows;               // per pattern
+    uint8_t speed;              // ticks per row
+    uint8_t tempo;              // BPM, a tick is 2.5 / tempo seconds
+    uint8_t order_count;
+    uint8_t restart;            // order to continue at after the last one
+    uint8_t instrument_count;
+    const uint8_t* orders;
+    const uint16_t* patterns;   // offset of every pattern in pattern_data
+    const uint8_t* pattern_data;
+    const MusicInstrument* instruments;
+};
+
+// Game thread
+bool musicPlay(const MusicSong* song);   // false when no voices could be reserved
+void musicStop();                        // notes release
+bool musicIsPlaying();
+void musicSetVolume(uint8_t volume);     // 0-255
+
+// Cost of the player per block, in cycles (nanoseconds in host builds)
+uint32_t musicGetBlockCycles();          // average over the last 64 blocks
+uint32_t musicGetMaxBlockCycles();       // since musicPlay
+#endif
@@ -0,0 +1,59 @@
+#ifndef NOTETABLES_H
+#define NOTETABLES_H
+
+#include <stdint.h>
+
+// Configuration
+#ifndef TONE_SAMPLE_RATE
+#define TONE_SAMPLE_RATE 44100        // must match the rate given to setupI2SAudio (SAMPLERATE)
+#endif
+#ifndef TONE_TICKS_PER_SECOND
+#define TONE_TICKS_PER_SECOND 240     // duration unit of the integer tone api
+#endif
+
+// Compile time tables for the integer tone api in i2stones: phase increments per
+// MIDI note and sample counts per tick duration, so triggering a note is a table
+// lookup instead of soft float / double math on the M33.
+// Note 69 is A4 (440 Hz), 60 is middle C, every step is a semitone.
+
+// Integer conversion of a duration, for durations known at compile time
+#define TONE_MS_TO_TICKS(ms) ((ms) * TONE_TICKS_PER_SECOND / 1000)
+
+// Phase increment of 1 Hz scaled by 256, used for tones given in whole Hz
+#define TONE_HZ_INCREMENT_X256 ((uint32_t)((1099511627776ull + TONE_SAMPLE_RATE / 2) / TONE_SAMPLE_RATE))
+
+struct ToneNoteTable {
+    uint32_t increment[128];
+    constexpr ToneNoteTable() : increment() {
+        double frequency = 8.175798915643707;  // MIDI note 0
+        for (int note = 0; note < 128; note++) {
+            increment[note] = (uint32_t)(frequency * 4294967296.0 / TONE_SAMPLE_RATE + 0.5);
+            frequency *= 1.0594630943592953;   // 2^(1/12)
+        }
+    }
+};
+
+struct ToneTickTable {
+    uint32_t samples[256];
+    constexpr ToneTickTable() : samples() {
+        for (int ticks = 0; ticks < 256; ticks++) {
+            samples[ticks] = (uint32_t)(((uint64_t)ticks * TONE_SAMPLE_RATE + TONE_TICKS_PER_SECOND / 2) / TONE_TICKS_PER_SECOND);
+        }
+    }
+};
+
+static constexpr ToneNoteTable tone_note_table;
+static constexpr ToneTickTable tone_tick_table;
+
+static inline uint32_t toneNoteIncrement(uint8_t note) {
+    return tone_note_table.increment[note & 0x7F];
+}
+
+static inline uint32_t toneHzIncrement(uint16_t frequency) {
+    return (uint32_t)(((uint64_t)frequency * TONE_HZ_INCREMENT_X256) >> 8);
+}
+
+static inline uint32_t toneTicksToSamples(uint8_t ticks) {
+    return tone_tick_table.samples[ticks];
+}
+#endif
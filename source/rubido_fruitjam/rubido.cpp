@@ -6,10 +6,15 @@
 #include "cmainmenu.h"
 #include "cpeg.h"
 #include "cselector.h"
+#include "cjumpanim.h"
+#include "tween.h"
 #include "commonvars.h"
 #include "framebuffer.h"
 #include "glcdfont.h"
 #include "usbh_processor.h"
+#include "framepacer.h"
+#include "transition.h"
+#include "drawlist.h"
 #include "images/veryeasy1_RGB565_LE.h"
 #include "images/veryhard1_RGB565_LE.h"
 #include "images/hard1_RGB565_LE.h"
@@ -21,6 +26,16 @@
 #include "images/infoveryhard_RGB565_LE.h"
 #include "images/background_RGB565_LE.h"
 
+// frame rate the current scene asked for, transitions run at FPS until they are done
+static uint16_t SceneFps = FPS;
+
+void SetSceneFps(uint16_t Fps)
+{
+	SceneFps = Fps;
+	if (!transitionIsActive())
+		framePacerSetTargetFps(Fps);
+}
+
 // Load the settings, if there isn't a settings file, set some initial values
 void LoadSettings()
 {
@@ -46,6 +61,7 @@ void LoadSettings()
 		BestPegsLeft[Hard] = 0;
 		BestPegsLeft[VeryHard] = 0;
 		setSoundOn(true);
+		setMusicOn(true);
 	//}
 }
 
@@ -84,6 +100,7 @@ void setupGame()
 	BoardParts = CBoardParts_Create();
 	Menu = CMainMenu_Create();
 	GameSelector = CSelector_Create(4,4);
+	JumpAnim = CJumpAnim_Create();
 }
 
 void terminateGame()
@@ -91,6 +108,7 @@ void terminateGame()
 	CBoardParts_Destroy(BoardParts);
 	CMainMenu_Destroy(Menu);
 	CSelector_Destroy(GameSelector);
+	CJumpAnim_Destroy(JumpAnim);
 	deInitSound();
 	SaveSettings();
 }
@@ -153,10 +171,10 @@ int PegsLeft()
 void PrintForm(const char *msg)
 {
 	PrintFormShown = true;
-	bufferFillRect(&fb,3,75,231,160-55,COLOR_BACKGROUND);
-	bufferDrawRect(&fb,3,75,231,160-55,COLOR_FOREGROUND);
-	bufferDrawRect(&fb,5,77,231-4,160-55-4,COLOR_FOREGROUND);
-	bufferPrint(&fb,9,85,msg,COLOR_FOREGROUND,COLOR_FOREGROUND,1,font);
+	drawListFillRect(3,75,231,160-55,COLOR_BACKGROUND);
+	drawListRect(3,75,231,160-55,COLOR_FOREGROUND);
+	drawListRect(5,77,231-4,160-55-4,COLOR_FOREGROUND);
+	drawListPrint(9,85,msg,COLOR_FOREGROUND,COLOR_FOREGROUND,1,font);
 }
 
 // this will ceate the initial board state, io a cross of pegs, with the middle on being empty (=animphase 6)
@@ -197,8 +215,31 @@ bool IsWinningGame()
         return false;
 }
 
+// the display is double buffered, after anything besides the jump animation changed
+// both buffers need a full redraw before we can go back to only redrawing dirty rects
+int FullRedrawFrames = 2;
+
+// redraw only the areas the jump animation touched
+void GameDrawDirty()
+{
+	FbRect Rects[JumpAnimHistory * JumpAnimRectsPerFrame];
+	int Count = CJumpAnim_GetDirtyRects(JumpAnim, Rects, JumpAnimHistory * JumpAnimRectsPerFrame);
+	// clipped to each rect, tiles overlapping it only redraw their part inside it
+	// and the background under a tile gets culled by the draw list
+	for (int I = 0; I < Count; I++)
+	{
+		drawListSetClip(Rects[I].x, Rects[I].y, Rects[I].w, Rects[I].h);
+		drawListImage(0, 0, background_data, background_width, background_height, false, true, false);
+		CBoardParts_DrawArea(BoardParts, &Rects[I]);
+	}
+	drawListResetClip();
+}
+
 void GameInit()
 {
+	SetSceneFps(FPS);
+	CJumpAnim_Stop(JumpAnim);
+	FullRedrawFrames = 2;
 	CSelector_SetPosition(GameSelector, 4, 4);
 	InitBoard();
     Moves = 0;
@@ -214,27 +255,47 @@ void Game()
 		GameInit();
 		GameState -= GSInitDiff;
 	}
-	bufferDrawImage(&fb,0,0,background_data, background_width, background_height, false, true, false);
-	char Msg[100];
+	tweenUpdateAll();
+	CJumpAnim_Update(JumpAnim);
+
+	// input is handled after drawing, so this frame still shows the old state
+	// and the next 2 frames need to get the new one in both buffers
+	if ((currButtons != prevButtons) || usbhInputChanged() || PrintFormShown || transitionIsActive())
+		FullRedrawFrames = 3;
+
+	// everything below gets recorded and drawn band by band at drawListExecute()
+	drawListBegin(&fb);
+	if (FullRedrawFrames > 0)
+	{
+		FullRedrawFrames--;
+		drawListImage(0,0,background_data, background_width, background_height, false, true, false);
+		char Msg[100];
 
-	// Write some info to the screen
-	sprintf(Msg, "Moves Left:%d", MovesLeft());
-	bufferPrint(&fb, 242, 37, Msg, COLOR_FOREGROUND, COLOR_FOREGROUND,1,font);
+		// Write some info to the screen
+		sprintf(Msg, "Moves Left:%d", MovesLeft());
+		drawListPrint(242, 37, Msg, COLOR_FOREGROUND, COLOR_FOREGROUND,1,font);
 	
-	sprintf(Msg, "Moves:%d", Moves);
-	bufferPrint(&fb, 242, 53, Msg, COLOR_FOREGROUND, COLOR_FOREGROUND,1,font);
+		sprintf(Msg, "Moves:%d", Moves);
+		drawListPrint(242, 53, Msg, COLOR_FOREGROUND, COLOR_FOREGROUND,1,font);
 
-	sprintf(Msg, "Pegs Left:%d", PegsLeft());
-	bufferPrint(&fb, 242, 69, Msg, COLOR_FOREGROUND, COLOR_FOREGROUND,1,font);
+		sprintf(Msg, "Pegs Left:%d", PegsLeft());
+		drawListPrint(242, 69, Msg, COLOR_FOREGROUND, COLOR_FOREGROUND,1,font);
 
-	// Only show best pegs if it isn't 0
-	if (BestPegsLeft[Difficulty] != 0)
-	{
-		sprintf(Msg, "Best Pegs:%d", BestPegsLeft[Difficulty]);
-		bufferPrint(&fb, 242, 85, Msg, COLOR_FOREGROUND, COLOR_FOREGROUND,1,font);
+		// Only show best pegs if it isn't 0
+		if (BestPegsLeft[Difficulty] != 0)
+		{
+			sprintf(Msg, "Best Pegs:%d", BestPegsLeft[Difficulty]);
+			drawListPrint(242, 85, Msg, COLOR_FOREGROUND, COLOR_FOREGROUND,1,font);
+		}
+		CBoardParts_Draw(BoardParts);
 	}
-	CBoardParts_Draw(BoardParts);
+	else
+		GameDrawDirty();
+	CJumpAnim_Draw(JumpAnim);
 	CSelector_Draw(GameSelector);
+	// keep frames coming while the jump is animating
+	if (CJumpAnim_NeedsRedraw(JumpAnim))
+		framePacerMarkDirty();
 
 	//need to repeat showing it until it's no longer shown
 	if (PrintFormShown)
@@ -249,6 +310,7 @@ void Game()
 			PrintForm("You couldn't solve the puzzle!\nDon't give up, try it again!\n\nPress (A) to continue");
 		}
 	}
+	drawListExecute();
 
 	if(gamepadButtonJustPressed(GAMEPAD_LEFT) || keyJustPressed(LEFTKEY))
 		if (!PrintFormShown)
@@ -318,6 +380,7 @@ void Game()
 	{
 		GameState = GSTitleScreenInit;
 		PrintFormShown = false;
+		CJumpAnim_Stop(JumpAnim);
 		playMenuBackSound();
 	}
 
@@ -337,11 +400,15 @@ void Game()
 				// see if the selected boardpart can move to the current position
 				if (CPeg_CanMoveTo(CBoardParts_GetPart(BoardParts, CSelector_GetSelection(GameSelector).X, CSelector_GetSelection(GameSelector).Y), CSelector_GetPosition(GameSelector).X, CSelector_GetPosition(GameSelector).Y, true))
 				{
-					playGameAction();
+					playGameAction(CSelector_GetPosition(GameSelector).X);
 					//if so play a sound, increase the moves, set the selected part to empty and the current part to red
 					Moves++;
 					CPeg_SetAnimPhase(CBoardParts_GetPart(BoardParts, CSelector_GetSelection(GameSelector).X, CSelector_GetSelection(GameSelector).Y), 6);
 					CPeg_SetAnimPhase(CBoardParts_GetPart(BoardParts, CSelector_GetPosition(GameSelector).X, CSelector_GetPosition(GameSelector).Y), 0);
+					// the peg we jumped over is halfway between the selection and the current position
+					CJumpAnim_Start(JumpAnim, CBoardParts_GetPart(BoardParts, CSelector_GetSelection(GameSelector).X, CSelector_GetSelection(GameSelector).Y),
+						CBoardParts_GetPart(BoardParts, (CSelector_GetSelection(GameSelector).X + CSelector_GetPosition(GameSelector).X) / 2, (CSelector_GetSelection(GameSelector).Y + CSelector_GetPosition(GameSelector).Y) / 2),
+						CBoardParts_GetPart(BoardParts, CSelector_GetPosition(GameSelector).X, CSelector_GetPosition(GameSelector).Y));
 					// if no moves are left see if the best pegs left value for the current difficulty is
 					// greater if so set te new value
 					if (MovesLeft() == 0)
@@ -371,7 +438,7 @@ void Game()
 				else // if we can't move to the spot, play the wrong move sound, and reset the selection to a red peg (instead of blue / selected)
 				{
 					CPeg_SetAnimPhase(CBoardParts_GetPart(BoardParts, CSelector_GetSelection(GameSelector).X, CSelector_GetSelection(GameSelector).Y), 0);
-					playErrorSound();
+					playErrorSound(CSelector_GetPosition(GameSelector).X);
 				}
 				CSelector_DeSelect(GameSelector); // deselect the selection
 			}
@@ -379,7 +446,7 @@ void Game()
 			{
 				if (CPeg_GetAnimPhase(CBoardParts_GetPart(BoardParts, CSelector_GetPosition(GameSelector).X, CSelector_GetPosition(GameSelector).Y)) == 0)
 				{
-					playGameAction();
+					playGameAction(CSelector_GetPosition(GameSelector).X);
 					CPeg_SetAnimPhase(CBoardParts_GetPart(BoardParts, CSelector_GetPosition(GameSelector).X, CSelector_GetPosition(GameSelector).Y), 1);
 					CSelector_Select(GameSelector);
 				}
@@ -391,7 +458,7 @@ void Game()
 
 void TitleScreenInit()
 {
-
+	SetSceneFps(FPS_MENU);
 }
 
 // main title screen loop
@@ -432,6 +499,7 @@ void TitleScreen()
 
 void DifficultySelectInit()
 {
+	SetSceneFps(FPS_MENU);
 }
 
 // Main difficulty select loop
@@ -528,6 +596,7 @@ void DifficultySelect()
 
 void CreditsInit()
 {
+	SetSceneFps(FPS_MENU);
 }
 
 //Main Credits loop, will just show an image and wait for a button to be pressed
@@ -549,8 +618,27 @@ void Credits()
 	bufferDrawImage(&fb,0,0,credits_data, credits_width, credits_height, false, true, false);
 }
 
+// the transition used when entering a game state
+int GetStateTransition(int NewState)
+{
+	switch(NewState)
+	{
+		case GSDifficultySelectInit:
+			return TRANSITION_CROSSFADE;
+		case GSGameInit:
+			return TRANSITION_FADE_BLACK;
+		case GSCreditsInit:
+			return TRANSITION_WIPE_DOWN;
+		case GSTitleScreenInit:
+			return TRANSITION_WIPE_LEFT;
+		default:
+			return TRANSITION_NONE;
+	}
+}
+
 void mainLoop(void)
 {
+	int PrevGameState = GameState;
     switch(GameState)
     {
 		case GSGameInit:
@@ -572,4 +660,20 @@ void mainLoop(void)
 		default:
 			break;
     }
-}
+
+	// blend the outgoing scene over what the new scene just drew
+	if (transitionIsActive())
+	{
+		transitionApply(&fb);
+		framePacerMarkDirty();
+		if (!transitionIsActive())
+			framePacerSetTargetFps(SceneFps);
+	}
+
+	// the buffer holds the last frame of the old scene now, start the transition from it
+	if ((GameState != PrevGameState) && (GameState > GSInitDiff))
+	{
+		if (transitionBegin(&fb, GetStateTransition(GameState), TRANSITION_FRAMES))
+			framePacerSetTargetFps(FPS);
+	}
+}
\ No newline at end of file
@@ -12,14 +12,16 @@
 #include "framebuffer.h"
 #include "usbh_processor.h"
 #include "i2stones.h"
+#include "framepacer.h"
+#include "drawlist.h"
+#include "musicplayer.h"
+#include "inputlatency.h"
 
 static uint32_t core1_stack[CORE1_STACK_SIZE / sizeof(uint32_t)];
 Adafruit_USBH_Host USBHost;
 
-const uint16_t timePerFrame =  1000000 / FPS; 
 static float frameRate = 0;
-static uint32_t currentTime = 0, lastTime = 0, frameTime = 0;
-static bool endFrame = true;
+static uint32_t frameTime = 0;
 
 uint32_t getFreeRam() { 
   return rp2040.getFreeHeap();
@@ -42,22 +44,55 @@ void printDebugCpuRamLoad()
     if(debugMode)
     {
         int currentFPS = (int)frameRate;
-        char debuginfo[80];
+        char debuginfo[200];
+        // buffer fill histogram, one digit per bucket: tenths of the refills that found it that full
+        AudioTimingStats audioTiming;
+        getI2SAudioTiming(&audioTiming);
+        uint32_t fills = 0;
+        for (int i = 0; i < AUDIO_FILL_BUCKETS; i++)
+            fills += audioTiming.fill_histogram[i];
+        char fillinfo[AUDIO_FILL_BUCKETS + 1];
+        for (int i = 0; i < AUDIO_FILL_BUCKETS; i++)
+        {
+            uint32_t tenths = fills ? (audioTiming.fill_histogram[i] * 10 + fills / 2) / fills : 0;
+            fillinfo[i] = '0' + (tenths > 9 ? 9 : tenths);
+        }
+        fillinfo[AUDIO_FILL_BUCKETS] = 0;
         
         int fps_int = (int)frameRate;
         int fps_frac = (int)((frameRate - fps_int) * 100);
         float cpuTemp = analogReadTemp();
         int cpuTemp_int = (int)cpuTemp;
         int cpuTemp_frac = (int)((cpuTemp - cpuTemp_int) * 100);
-        sprintf(debuginfo, "F:%3d.%2d R:%3d A:%2d B:%d%% O:%d U:%d C:%2d.%2d", 
+        int used = snprintf(debuginfo, sizeof(debuginfo), "F:%3d.%2d R:%3d A:%2d B:%s Q:%d C:%2d.%2d\nI:%3d%% S:%d D:%d/%d M:%d/%d L:%d", 
             fps_int, fps_frac, getFreeRam(), 
             getActiveChannelCount(), 
-            (getBufferAvailable()*100)/getActualBufferSize(),
-            getBufferSkipCount(),
-            getBufferUnderrunCount(),
+            fillinfo,
+            audioMixerReadyBlocks(),
             cpuTemp_int,
-            cpuTemp_frac
+            cpuTemp_frac,
+            framePacerGetIdlePercent(),
+            framePacerGetSkippedFrames(),
+            drawListGetCommandCount(),
+            drawListGetCulledCount(),
+            (int)musicGetBlockCycles(),
+            (int)musicGetMaxBlockCycles(),
+            (int)audioTiming.latency_avg_us
         );
+        // input to photon latency in ms, p50/p99 per device: keyboard, pad, board buttons
+        const char deviceNames[INPUT_DEVICE_COUNT] = { 'K', 'P', 'B' };
+        char latencyinfo[24];   // "K:4294967.2/4294967.2 " at worst
+        for (int device = 0; device < INPUT_DEVICE_COUNT; device++)
+        {
+            uint32_t p50, p99;
+            if (inputLatencyGetPercentiles(device, &p50, &p99))
+                snprintf(latencyinfo, sizeof(latencyinfo), "%c:%d.%d/%d.%d ", deviceNames[device],
+                    (int)(p50 / 1000), (int)(p50 / 100 % 10), (int)(p99 / 1000), (int)(p99 / 100 % 10));
+            else
+                snprintf(latencyinfo, sizeof(latencyinfo), "%c:- ", deviceNames[device]);
+            if (used >= 0 && used < (int)sizeof(debuginfo))
+                used += snprintf(debuginfo + used, sizeof(debuginfo) - used, "%s%s", device == 0 ? "\n" : "", latencyinfo);
+        }
         //Serial.println(debuginfo); 
         bufferPrint(&fb, 0, 0, debuginfo, tft.color565(255,255,255), tft.color565(0,0,0), 1, font);
     }
@@ -104,6 +139,8 @@ void core1_setup()
 void core1_loop()
 {
     USBHost.task();
+    // codec I2C (headphone jack, output switching) stays off the game loop
+    serviceI2SAudioControl();
     delayMicroseconds(100);
 }
 
@@ -133,29 +170,33 @@ void setup()
     fb.buffer = tft.getBuffer();
     fb.width = tft.width();
     fb.height = tft.height();
+    bufferResetClip(&fb);
     fb.littleEndian = 1;
     fb.bgr = 0;
 
     setupButtons();
     setupGame();
-    currentTime = micros();
-    lastTime = 0;
+    framePacerInit(FPS);
 }
 
 void loop()
 {
-    updateI2SAudio();
-    
-    currentTime = micros();
-    frameTime  = currentTime - lastTime;  
-    if((frameTime < timePerFrame) || !endFrame)
-       return;     
-    endFrame = false;
+    framePacerWaitForFrame(updateI2SAudio);
+    frameTime = framePacerGetFrameTime();
     frameRate = 1000000.0 / frameTime;
-    lastTime = currentTime;
     prevButtons = currButtons;
+    uint32_t buttonsReadTime = micros();
     currButtons = readButtons();
     updateUSBHButtons();
+
+    // presses this frame consumes, measured up to the swap that shows their result
+    uint32_t pressedTime;
+    if (currButtons & ~prevButtons)
+        inputLatencyMark(INPUT_DEVICE_BUTTONS, buttonsReadTime);
+    if (usbhGetKeyboardPressTime(&pressedTime))
+        inputLatencyMark(INPUT_DEVICE_KEYBOARD, pressedTime);
+    if (usbhGetGamepadPressTime(&pressedTime))
+        inputLatencyMark(INPUT_DEVICE_GAMEPAD, pressedTime);
     
     if(gamepadButtonJustPressed(GAMEPAD_LEFT_SHOULDER) || keyJustPressed(F1KEY) ||
 		((currButtons & BUTTON_2_MASK) && (currButtons & BUTTON_1_MASK) && ! (prevButtons & BUTTON_1_MASK)))
@@ -167,11 +208,24 @@ void loop()
 
     if(gamepadButtonJustPressed(GAMEPAD_SELECT) || keyJustPressed(DKEY))
         debugMode = !debugMode;
-    
+
+    // scenes only change on input, the debug overlay changes every frame
+    bool inputChanged = (currButtons != prevButtons) || usbhInputChanged();
+    if(inputChanged || debugMode)
+        framePacerMarkDirty();
+
+    if(!framePacerBeginRender())
+        return;
+
+    int prevGameState = GameState;
     mainLoop();
+    // scenes draw before handling input and a new state still needs
+    // to draw its first frame, so both need one more frame to show up
+    if(inputChanged || (GameState != prevGameState))
+        framePacerMarkDirty();
 
     printDebugCpuRamLoad();
     tft.swap();
+    inputLatencyFrameShown(micros());
     fb.buffer = tft.getBuffer();
-    endFrame = true;
-}
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+// Generated from: pegclick.wav
+// Format: IMA_ADPCM
+// Original size: 1323 samples at 22050 Hz = 2646 bytes, 662 bytes encoded
+
+const uint8_t pegclick_data[] PROGMEM = {
+    0x90, 0xB6, 0x84, 0x39, 0x3B, 0x09, 0x23, 0x0D, 0x03, 0xA8, 0xF3, 0xA3, 0x09, 0x20, 0x1C, 0xA0,
+    0xB0, 0x08, 0xA3, 0x29, 0xAA, 0x95, 0x2B, 0x38, 0xDA, 0xD5, 0x11, 0x1B, 0x29, 0x98, 0xC1, 0x91,
+    0x98, 0x80, 0x8D, 0x1C, 0x09, 0xDA, 0x88, 0x0B, 0x9B, 0x29, 0x8D, 0x10, 0x1C, 0x10, 0x10, 0x2A,
+    0x62, 0x92, 0x32, 0x53, 0x13, 0x62, 0x31, 0x13, 0x32, 0x03, 0x17, 0x11, 0x10, 0x20, 0x18, 0x11,
+    0x00, 0x18, 0x00, 0x49, 0xA9, 0x08, 0x98, 0x04, 0x0B, 0x0A, 0x02, 0xB4, 0x78, 0x99, 0xB0, 0x81,
+    0xDB, 0xAD, 0xBB, 0xAE, 0xBD, 0xCA, 0xCB, 0xCB, 0xAC, 0xCB, 0xBB, 0xBB, 0xBC, 0xCB, 0xBA, 0xBB,
+    0xBA, 0xAA, 0xA9, 0x09, 0x18, 0x32, 0x35, 0x45, 0x43, 0x43, 0x43, 0x33, 0x34, 0x24, 0x43, 0x32,
+    0x33, 0x33, 0x34, 0x33, 0x24, 0x33, 0x43, 0x33, 0x43, 0x33, 0x34, 0x43, 0x33, 0x34, 0x33, 0x34,
+    0x43, 0x32, 0x22, 0x22, 0x02, 0x80, 0xBA, 0xDD, 0xDB, 0xBC, 0xBD, 0xDB, 0xCB, 0xBB, 0xCC, 0xBB,
+    0xCB, 0xBB, 0xBC, 0xCB, 0xBA, 0xAB, 0xAC, 0xAA, 0xAA, 0xAA, 0xA9, 0x98, 0x08, 0x10, 0x31, 0x43,
+    0x44, 0x33, 0x35, 0x43, 0x43, 0x43, 0x42, 0x32, 0x34, 0x43, 0x33, 0x34, 0x34, 0x34, 0x43, 0x43,
+    0x33, 0x34, 0x43, 0x33, 0x34, 0x43, 0x32, 0x33, 0x33, 0x33, 0x33, 0x22, 0x01, 0x90, 0xCB, 0xDC,
+    0xDB, 0xCB, 0xBC, 0xBC, 0xBC, 0xDB, 0xBA, 0xBC, 0xBB, 0xBC, 0xBB, 0xBC, 0xCB, 0xBA, 0xBB, 0xBB,
+    0xCB, 0xBA, 0xBB, 0xAB, 0xBB, 0xBB, 0xBA, 0xAA, 0x99, 0x09, 0x10, 0x43, 0x54, 0x53, 0x34, 0x44,
+    0x43, 0x34, 0x34, 0x34, 0x34, 0x34, 0x34, 0x43, 0x33, 0x44, 0x32, 0x33, 0x34, 0x33, 0x24, 0x33,
+    0x33, 0x32, 0x23, 0x22, 0x12, 0x80, 0xA9, 0xCB, 0xBD, 0xBD, 0xCC, 0xBB, 0xBD, 0xCB, 0xCB, 0xBB,
+    0xBC, 0xBC, 0xBB, 0xBC, 0xCB, 0xBB, 0xBC, 0xBB, 0xBC, 0xBB, 0xBC, 0xBB, 0xBC, 0xCA, 0xAA, 0xAB,
+    0xAB, 0xAB, 0xAA, 0x99, 0x08, 0x21, 0x44, 0x44, 0x34, 0x35, 0x34, 0x25, 0x34, 0x43, 0x33, 0x44,
+    0x32, 0x34, 0x33, 0x43, 0x43, 0x32, 0x33, 0x24, 0x33, 0x32, 0x33, 0x32, 0x23, 0x22, 0x11, 0x80,
+    0x99, 0xDB, 0xDB, 0xCB, 0xCC, 0xBB, 0xCC, 0xCB, 0xBB, 0xCC, 0xBB, 0xBC, 0xCB, 0xAC, 0xCB, 0xAB,
+    0xBC, 0xBB, 0xBC, 0xBB, 0xBC, 0xCB, 0xBA, 0xBB, 0xBB, 0xBB, 0xAB, 0xAB, 0x9A, 0x88, 0x21, 0x44,
+    0x34, 0x36, 0x53, 0x43, 0x43, 0x24, 0x24, 0x43, 0x33, 0x34, 0x33, 0x34, 0x34, 0x33, 0x24, 0x43,
+    0x32, 0x33, 0x33, 0x43, 0x33, 0x32, 0x33, 0x32, 0x22, 0x12, 0x00, 0xA9, 0xDB, 0xCC, 0xDB, 0xBC,
+    0xBC, 0xBC, 0xBD, 0xCB, 0xCB, 0xCB, 0xBB, 0xBC, 0xCB, 0xAC, 0xBB, 0xCB, 0xBB, 0xBC, 0xBA, 0xAC,
+    0xAB, 0xBB, 0xBB, 0xAB, 0xAB, 0x9A, 0x99, 0x10, 0x41, 0x53, 0x34, 0x35, 0x34, 0x34, 0x25, 0x24,
+    0x43, 0x33, 0x34, 0x34, 0x33, 0x34, 0x34, 0x33, 0x34, 0x33, 0x34, 0x43, 0x32, 0x33, 0x24, 0x23,
+    0x23, 0x23, 0x22, 0x12, 0x00, 0x98, 0xCB, 0xCC, 0xBC, 0xBD, 0xCC, 0xBB, 0xBD, 0xCB, 0xBC, 0xBB,
+    0xBC, 0xBC, 0xAC, 0xCB, 0xBA, 0xCB, 0xBB, 0xBB, 0xCB, 0xBB, 0xCB, 0xBA, 0xAA, 0xAB, 0xAB, 0x99,
+    0x99, 0x18, 0x31, 0x53, 0x35, 0x34, 0x35, 0x34, 0x25, 0x43, 0x43, 0x43, 0x42, 0x32, 0x34, 0x33,
+    0x34, 0x24, 0x43, 0x32, 0x43, 0x32, 0x33, 0x24, 0x23, 0x33, 0x33, 0x32, 0x22, 0x11, 0x91, 0xB8,
+    0xEB, 0xBB, 0xBD, 0xCC, 0xCB, 0xDB, 0xBB, 0xDB, 0xBB, 0xDB, 0xBB, 0xCB, 0xBB, 0xBC, 0xCB, 0xBB,
+    0xAC, 0xBB, 0xAC, 0xBB, 0xBB, 0xAC, 0xAB, 0xAB, 0xAA, 0xAA, 0xA9, 0x90, 0x31, 0x33, 0x35, 0x34,
+    0x34, 0x35, 0x34, 0x34, 0x34, 0x34, 0x34, 0x43, 0x33, 0x34, 0x43, 0x33, 0x34, 0x33, 0x34, 0x43,
+    0x32, 0x33, 0x33, 0x33, 0x33, 0x33, 0x32, 0x12, 0x01, 0xB9, 0xBB, 0xBC, 0xBC, 0xBD, 0xBC, 0xBC,
+    0xBC, 0xBC, 0xBC, 0xCB, 0xCB, 0xBB, 0xBC, 0xCB, 0xBB, 0xCB, 0xBB, 0xBC, 0xBB, 0xCB, 0xAB, 0xBB,
+    0xBB, 0xAC, 0xAA, 0x9A, 0xA9, 0x09, 0x11, 0x33, 0x33, 0x35, 0x33, 0x35, 0x53, 0x43, 0x33, 0x34,
+    0x34, 0x53, 0x32, 0x24, 0x43, 0x32, 0x43, 0x32, 0x33, 0x34, 0x32, 0x24, 0x23, 0x33, 0x23, 0x33,
+    0x23, 0x11, 0x01, 0x99, 0xAA, 0xBB, 0xCB, 0xBB, 0xBC, 0xBC, 0xBC, 0xBD, 0xBB, 0xBC, 0xBC, 0xAC,
+    0xCB, 0xBB, 0xCB, 0xBB, 0xBC, 0xCB, 0xBA, 0xBB, 0xCB, 0xBA, 0xAB, 0xBB, 0xBB, 0x9B, 0x9A, 0x00,
+    0x10, 0x12, 0x33, 0x33, 0x43, 0x33, 0x53, 0x33, 0x34, 0x43, 0x43, 0x33, 0x34, 0x43, 0x33, 0x24,
+    0x24, 0x33, 0x43, 0x33, 0x33, 0x53, 0x22, 0x22, 0x32, 0x22, 0x21, 0x11, 0x01, 0x99, 0x99, 0x9B,
+    0xBB, 0xBB, 0xBB, 0xAD, 0xBA, 0x0B
+};
+
+const AudioSample pegclick_sample = { pegclick_data, 1323, 22050, -5919, 78 };
@@ -3,18 +3,37 @@
 #include "sound.h"
 #include "commonvars.h"
 #include "i2stones.h"
+#include "soundbank.h"
+#include "musicplayer.h"
+#include "musicdata.h"
+#include "samples/pegclick_ADPCM.h"
 
 #define MAX_VOL 20
+#define COLUMN_PAN_MAX 96
 
-int sound_on = 0, sound_vol = 3, sound_init_success = 0;
-const float musModifier = (60.0f / 45.0f);
-const float sfxSustain = (100.0f * 15.0f / 18.0f) / 1000.0f;
+int sound_on = 0, music_on = 0, sound_vol = 3, sound_init_success = 0;
+
+static inline uint8_t soundVolume(void)
+{
+    return sound_vol * 255 / MAX_VOL;
+}
+
+// board column to stereo position, the outer columns stay a bit in both ears
+static inline int8_t columnPan(int column)
+{
+    if(column < 0)
+        column = 0;
+    if(column > NrOfCols - 1)
+        column = NrOfCols - 1;
+    return (int8_t)((column * 2 - (NrOfCols - 1)) * COLUMN_PAN_MAX / (NrOfCols - 1));
+}
 
 void incVolumeSound(void)
 {
     sound_vol++;
     if(sound_vol > MAX_VOL)
         sound_vol = MAX_VOL;
+    musicSetVolume(soundVolume());
 }
 
 void decVolumeSound(void)
@@ -22,6 +41,7 @@ void decVolumeSound(void)
     sound_vol--;
     if(sound_vol < 0)
         sound_vol = 0;
+    musicSetVolume(soundVolume());
 }
 
 void setSoundOn(int value)
@@ -34,6 +54,26 @@ int isSoundOn(void)
     return sound_on;
 }
 
+void setMusicOn(int value)
+{
+    music_on = value;
+    if(!sound_init_success)
+        return;
+    if(music_on)
+    {
+        musicSetVolume(soundVolume());
+        if(!musicIsPlaying())
+            musicPlay(&music_title);
+    }
+    else
+        musicStop();
+}
+
+int isMusicOn(void)
+{
+    return music_on;
+}
+
 
 void initSound(void)
 {
@@ -51,80 +91,73 @@ void initSound(void)
 
 void deInitSound(void)
 {
+    musicStop();
 }
 
 void playSelectSound(void)
 {
     if(!sound_on || !sound_init_success)
         return;
-    playTone(1250, sound_vol * 255/MAX_VOL, sfxSustain, 0);
+    soundBankPlay(SOUND_SELECT, soundVolume());
 }
 
-
-void playErrorSound(void)
+void playErrorSound(int column)
 {
     if(!sound_on || !sound_init_success)
         return;
-    playTone(210, sound_vol * 255/MAX_VOL, sfxSustain, 0);
+    soundBankPlay(SOUND_ERROR, soundVolume(), AUDIO_PRIORITY_NORMAL, columnPan(column));
 }
 
-
-void playGameAction(void)
+void playGameAction(int column)
 {
     if(!sound_on || !sound_init_success)
         return;
-    playTone(600, sound_vol * 255/MAX_VOL, sfxSustain, 0);
+    // the click on top of the tone, both start on the same sample and come from the column played
+    int8_t pan = columnPan(column);
+    beginToneGroup();
+    soundBankPlay(SOUND_GAME_ACTION, soundVolume(), AUDIO_PRIORITY_NORMAL, pan);
+    playSample(&pegclick_sample, soundVolume(), AUDIO_PITCH_NORMAL, AUDIO_PRIORITY_NORMAL, pan);
+    endToneGroup();
 }
 
 void playMenuSelectSound(void)
 {
     if(!sound_on || !sound_init_success)
         return;
-    playTone(1250, sound_vol * 255/MAX_VOL, sfxSustain, 0);
+    soundBankPlay(SOUND_MENU_SELECT, soundVolume());
 }
 
 void playMenuBackSound(void)
 {
     if(!sound_on || !sound_init_success)
         return;
-    playTone(1000, sound_vol * 255/MAX_VOL, sfxSustain, 0);
+    soundBankPlay(SOUND_MENU_BACK, soundVolume());
 }
 
 void playMenuAcknowlege(void)
 {
     if(!sound_on || !sound_init_success)
         return;
-    playTone(900, sound_vol * 255/MAX_VOL, sfxSustain, 0);
+    soundBankPlay(SOUND_MENU_ACKNOWLEDGE, soundVolume());
 }
 
 void playWinnerSound(void)
 {
     if(!sound_on || !sound_init_success)
         return;
-    playTone(523, sound_vol * 255/MAX_VOL, (100.0f / musModifier) / 1000.0f, (150.0f + 0.0f / musModifier) / 1000.0f);
-    playTone(659, sound_vol * 255/MAX_VOL, (100.0f / musModifier) / 1000.0f, (150.0f + 100.0f / musModifier) / 1000.0f);
-    playTone(783, sound_vol * 255/MAX_VOL, (100.0f / musModifier) / 1000.0f, (150.0f + 2.0f * 100.0f / musModifier) / 1000.0f);
-    playTone(1046, sound_vol * 255/MAX_VOL, (300.0f / musModifier) / 1000.0f, (150.0f + 3.0f * 100.0f / musModifier) / 1000.0f); 
-    playTone(1318, sound_vol * 255/MAX_VOL, (500.0f / musModifier) / 1000.0f, (150.0f + (3.0f * 100.0f / musModifier) + (300.0f / musModifier)) / 1000.0f); 
+    soundBankPlay(SOUND_WINNER, soundVolume());
 }
 
 void playLoserSound(void)
 {
     if(!sound_on || !sound_init_success)
         return;
-    playTone(392, sound_vol * 255/MAX_VOL, (200.0f / musModifier) / 1000.0f, (150.0f + 0.0f / musModifier) / 1000.0f);
-    playTone(369, sound_vol * 255/MAX_VOL, (200.0f / musModifier) / 1000.0f, (150.0f + 200.0f / musModifier) / 1000.0f);
-    playTone(329, sound_vol * 255/MAX_VOL, (300.0f / musModifier) / 1000.0f, (150.0f + 2.0f * 200.0f / musModifier) / 1000.0f);
-    playTone(293, sound_vol * 255/MAX_VOL, (300.0f / musModifier) / 1000.0f, (150.0f + (2.0f * 200.0f / musModifier) + (300.0f / musModifier)) / 1000.0f);
-    playTone(277, sound_vol * 255/MAX_VOL, (500.0f / musModifier) / 1000.0f, (150.0f + (2.0f * 200.0f / musModifier) + (2.0f * 300.0f / musModifier)) / 1000.0f);
+    soundBankPlay(SOUND_LOSER, soundVolume());
 }
 
 void playStartSound(void)
 {
     if(!sound_on || !sound_init_success)
         return;
-    playTone(784, sound_vol * 255/MAX_VOL * 1.0f, (150.0f / musModifier) / 1000.0f, (150.0f + 0.0f / musModifier) / 1000.0f);
-    playTone(523, sound_vol * 255/MAX_VOL * 0.9f, (150.0f / musModifier) / 1000.0f, (150.0f + 150.0f / musModifier) / 1000.0f);
-    playTone(659, sound_vol * 255/MAX_VOL * 0.8f, (200.0f / musModifier) / 1000.0f, (150.0f + 300.0f / musModifier) / 1000.0f);
-    playTone(1047, sound_vol * 255/MAX_VOL * 0.7f, (300.0f / musModifier) / 1000.0f, (150.0f + 500.0f / musModifier) / 1000.0f);
-}
\ No newline at end of file
+    soundBankPlay(SOUND_START, soundVolume());
+}
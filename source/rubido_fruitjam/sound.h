@@ -9,8 +9,9 @@ void initSound(void);
 void playLoserSound(void);
 void playWinnerSound(void);
 void playSelectSound(void);
-void playErrorSound(void);
-void playGameAction(void);
+// column is the board column the sound comes from, it sets the stereo position
+void playErrorSound(int column);
+void playGameAction(int column);
 void playMenuSelectSound(void);
 void playMenuBackSound(void);
 void playMenuAcknowlege(void);
@@ -18,6 +19,8 @@ void playStartSound(void);
 
 void setSoundOn(int value);
 int isSoundOn(void);
+void setMusicOn(int value);
+int isMusicOn(void);
 void deInitSound(void);
 void incVolumeSound(void);
 void decVolumeSound(void);
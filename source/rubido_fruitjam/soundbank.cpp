@@ -0,0 +1,37 @@
+// soundbank.cpp - plays effects from the generated sound bank on mixer tracks
+
+#include "soundbank.h"
+#include "soundbankdata.h"
+#include <stddef.h>
+
+// Effect record inside the bank, NULL for an unknown id
+static const uint8_t* effectRecord(uint8_t id) {
+    if (id >= sound_bank[0]) return NULL;
+    const uint8_t* entry = &sound_bank[1 + id * 2];
+    return &sound_bank[entry[0] | (entry[1] << 8)];
+}
+
+uint8_t soundBankGetTrackCount(uint8_t id) {
+    const uint8_t* record = effectRecord(id);
+    return record ? record[0] : 0;
+}
+
+int8_t soundBankPlay(uint8_t id, uint8_t volume, uint8_t priority, int8_t pan) {
+    const uint8_t* record = effectRecord(id);
+    if (!record) return -1;
+
+    uint8_t tracks = *record++;
+    int8_t first = -1;
+    // All tracks start on the same block
+    audioMixerBeginBatch();
+    for (uint8_t t = 0; t < tracks; t++) {
+        uint8_t count = *record++;
+        int8_t channel = audioMixerAllocVoice(priority);
+        if (channel >= 0 && audioMixerStartTrack(channel, record, count, sound_bank_envelopes, volume, pan, 0)) {
+            if (first < 0) first = channel;
+        }
+        record += count * AUDIO_TRACK_EVENT_BYTES;
+    }
+    audioMixerEndBatch();
+    return first;
+}
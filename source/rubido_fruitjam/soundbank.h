@@ -0,0 +1,21 @@
+#ifndef SOUNDBANK_H
+#define SOUNDBANK_H
+
+#include <stdint.h>
+#include "audiomixer.h"
+#include "soundbankids.h"
+
+// Sound effects from the generated sound bank (soundbankdata.h, made by
+// tools/soundbank/mksoundbank.py from tools/soundbank/sounds.txt).
+// An effect is one or more tracks of notes that never overlap within a track,
+// each track takes one mixer voice and the mixer starts its notes itself,
+// sample exact and just when they come up, so a five note jingle is one voice
+// and one command instead of five scheduled tones.
+// Typical usage:
+//   soundBankPlay(SOUND_WINNER, volume);
+//   soundBankPlay(SOUND_ERROR, volume, AUDIO_PRIORITY_NORMAL, pan);   // placed left / right
+
+// Starts effect id, returns the voice of its first track or -1
+int8_t soundBankPlay(uint8_t id, uint8_t volume, uint8_t priority = AUDIO_PRIORITY_NORMAL, int8_t pan = 0);
+uint8_t soundBankGetTrackCount(uint8_t id);   // voices the effect takes
+#endif
@@ -0,0 +1,29 @@
+// Generated from: sounds.txt by tools/soundbank/mksoundbank.py
+// 9 effects, 157 bytes
+
+#ifndef SOUNDBANKDATA_H
+#define SOUNDBANKDATA_H
+
+#include <stdint.h>
+#include "audiomixer.h"
+
+static const AudioEnvelope sound_bank_envelopes[] = {
+    { 1, 40, 120, 15 },   // click
+    { 2, 0, 255, 30 },   // buzz
+    { 1, 25, 170, 20 },   // action
+    { 4, 60, 190, 40 },   // jingle
+};
+
+static const uint8_t sound_bank[] = {
+    0x09, 0x13, 0x00, 0x1B, 0x00, 0x23, 0x00, 0x2B, 0x00, 0x33, 0x00, 0x3B, 0x00, 0x43, 0x00, 0x63,
+    0x00, 0x83, 0x00, 0x01, 0x01, 0x00, 0x00, 0x57, 0x14, 0x00, 0xFF, 0x01, 0x01, 0x00, 0x00, 0x38,
+    0x14, 0x01, 0xFF, 0x01, 0x01, 0x00, 0x00, 0x4A, 0x14, 0x02, 0xFF, 0x01, 0x01, 0x00, 0x00, 0x57,
+    0x14, 0x00, 0xFF, 0x01, 0x01, 0x00, 0x00, 0x53, 0x14, 0x00, 0xFF, 0x01, 0x01, 0x00, 0x00, 0x51,
+    0x14, 0x00, 0xFF, 0x01, 0x05, 0x24, 0x00, 0x48, 0x12, 0x03, 0xFF, 0x36, 0x00, 0x4C, 0x12, 0x03,
+    0xFF, 0x48, 0x00, 0x4F, 0x12, 0x03, 0xFF, 0x5A, 0x00, 0x54, 0x36, 0x03, 0xFF, 0x90, 0x00, 0x58,
+    0x5A, 0x03, 0xFF, 0x01, 0x05, 0x24, 0x00, 0x43, 0x24, 0x03, 0xFF, 0x48, 0x00, 0x42, 0x24, 0x03,
+    0xFF, 0x6C, 0x00, 0x40, 0x36, 0x03, 0xFF, 0xA2, 0x00, 0x3E, 0x36, 0x03, 0xFF, 0xD8, 0x00, 0x3D,
+    0x5A, 0x03, 0xFF, 0x01, 0x04, 0x24, 0x00, 0x4F, 0x1B, 0x03, 0xFF, 0x3F, 0x00, 0x48, 0x1B, 0x03,
+    0xE6, 0x5A, 0x00, 0x4C, 0x24, 0x03, 0xCC, 0x7E, 0x00, 0x54, 0x36, 0x03, 0xB3,
+};
+#endif
@@ -0,0 +1,18 @@
+// Generated from: sounds.txt by tools/soundbank/mksoundbank.py
+
+#ifndef SOUNDBANKIDS_H
+#define SOUNDBANKIDS_H
+
+enum SoundId {
+    SOUND_SELECT,
+    SOUND_ERROR,
+    SOUND_GAME_ACTION,
+    SOUND_MENU_SELECT,
+    SOUND_MENU_BACK,
+    SOUND_MENU_ACKNOWLEDGE,
+    SOUND_WINNER,
+    SOUND_LOSER,
+    SOUND_START,
+    SOUND_COUNT
+};
+#endif
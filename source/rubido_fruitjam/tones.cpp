@@ -0,0 +1,126 @@
+// tones.cpp - tone api of i2stones, queues voices for the mixer
+// Hardware independent, the output (I2S on the device, a file on the host) pulls the blocks
+
+#include "tones.h"
+#include "notetables.h"
+
+uint8_t getMaxChannels() {
+    return MAX_CHANNELS;
+}
+
+int8_t findFreeChannel() {
+    return audioMixerFindFreeVoice();
+}
+
+// Delays are counted in output samples from the block that picks the tone up
+static const AudioEnvelope default_envelope = AUDIO_ENVELOPE_DEFAULT;
+
+static bool queueTone(uint8_t channel, float frequency, uint8_t volume, float duration_sec, float delay_sec, uint8_t waveform, const AudioEnvelope* envelope) {
+    AudioVoiceParams params;
+    params.phase_increment = (uint32_t)((frequency * 4294967296.0) / audioMixerGetSampleRate());
+    params.duration_samples = (duration_sec > 0) ? (uint32_t)(audioMixerGetSampleRate() * duration_sec) : 0;
+    params.amplitude = volume;
+    params.waveform = waveform;
+    params.envelope = envelope ? *envelope : default_envelope;
+    params.pan = 0;
+    uint32_t delay_samples = (delay_sec > 0) ? (uint32_t)(audioMixerGetSampleRate() * delay_sec + 0.5f) : 0;
+    
+    return audioMixerStartVoice(channel, &params, delay_samples);
+}
+
+int8_t playTone(float frequency, uint8_t volume, float duration_sec, float delay_sec, uint8_t priority, uint8_t waveform, const AudioEnvelope* envelope) {
+    // Takes over a lower priority (or quieter / older) voice when all are busy
+    int8_t channel = audioMixerAllocVoice(priority);
+    if (channel < 0) return -1;
+    
+    if (!queueTone(channel, frequency, volume, duration_sec, delay_sec, waveform, envelope)) return -1;
+    return channel;
+}
+
+int8_t playToneOnChannel(uint8_t channel, float frequency, uint8_t volume, float duration_sec, float delay_sec, uint8_t waveform, const AudioEnvelope* envelope) {
+    if (channel >= MAX_CHANNELS) return -1;
+    
+    if (!queueTone(channel, frequency, volume, duration_sec, delay_sec, waveform, envelope)) return -1;
+    return channel;
+}
+
+void setChannelVolume(int8_t channel, uint8_t volume) {
+    if (channel >= 0 && channel < MAX_CHANNELS) {
+        audioMixerSetVoiceVolume(channel, volume);
+    }
+}
+
+void setChannelPan(int8_t channel, int8_t pan) {
+    if (channel >= 0 && channel < MAX_CHANNELS) {
+        audioMixerSetVoicePan(channel, pan);
+    }
+}
+
+// Integer api, increments and sample counts come from the compile time tables
+static int8_t queueToneInteger(uint32_t phase_increment, uint8_t volume, uint8_t duration_ticks, uint8_t delay_ticks, uint8_t priority, uint8_t waveform, const AudioEnvelope* envelope) {
+    int8_t channel = audioMixerAllocVoice(priority);
+    if (channel < 0) return -1;
+    
+    AudioVoiceParams params;
+    params.phase_increment = phase_increment;
+    params.duration_samples = toneTicksToSamples(duration_ticks);
+    params.amplitude = volume;
+    params.waveform = waveform;
+    params.envelope = envelope ? *envelope : default_envelope;
+    params.pan = 0;
+    if (!audioMixerStartVoice(channel, &params, toneTicksToSamples(delay_ticks))) return -1;
+    return channel;
+}
+
+int8_t playNote(uint8_t note, uint8_t volume, uint8_t duration_ticks, uint8_t delay_ticks, uint8_t priority, uint8_t waveform, const AudioEnvelope* envelope) {
+    return queueToneInteger(toneNoteIncrement(note), volume, duration_ticks, delay_ticks, priority, waveform, envelope);
+}
+
+int8_t playToneHz(uint16_t frequency, uint8_t volume, uint8_t duration_ticks, uint8_t delay_ticks, uint8_t priority, uint8_t waveform, const AudioEnvelope* envelope) {
+    return queueToneInteger(toneHzIncrement(frequency), volume, duration_ticks, delay_ticks, priority, waveform, envelope);
+}
+
+int8_t playSample(const AudioSample* sample, uint8_t volume, uint32_t pitch, uint8_t priority, int8_t pan) {
+    int8_t channel = audioMixerAllocVoice(priority);
+    if (channel < 0) return -1;
+    if (!audioMixerStartSample(channel, sample, pitch, volume, pan, 0)) return -1;
+    return channel;
+}
+
+void beginToneGroup() {
+    audioMixerBeginBatch();
+}
+
+void endToneGroup() {
+    audioMixerEndBatch();
+}
+
+void cancelScheduled(int8_t channel) {
+    if (channel >= 0 && channel < MAX_CHANNELS) {
+        audioMixerCancelVoice(channel);
+    }
+}
+
+void stopChannel(int8_t channel) {
+    if (channel >= 0 && channel < MAX_CHANNELS) {
+        // Don't instantly stop - the mixer fades out over the next 64 samples
+        audioMixerStopVoice(channel);
+    }
+}
+
+void stopAllTones() {
+    audioMixerStopAll();
+}
+
+bool isChannelActive(int8_t channel) {
+    if (channel < 0 || channel >= MAX_CHANNELS) return false;
+    return audioMixerIsVoiceActive(channel);
+}
+
+uint8_t getActiveChannelCount() {
+    return audioMixerGetActiveCount();
+}
+
+uint8_t getPlayingChannelCount() {
+    return audioMixerGetPlayingCount();
+}
@@ -0,0 +1,37 @@
+#ifndef TONES_H
+#define TONES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "audiomixer.h"
+
+// Tone api of i2stones: voices are handed to the mixer, which renders them for
+// whatever output pulls its blocks. Nothing here touches hardware, so it builds
+// on the host as well, where tools/render plays scripts of these calls to a WAV file.
+// On the Fruit Jam include i2stones.h, which sets up the codec and I2S output.
+
+int8_t playTone(float frequency, uint8_t volume, float duration_sec = 0, float delay_sec = 0, uint8_t priority = AUDIO_PRIORITY_NORMAL, uint8_t waveform = WAVE_SINE, const AudioEnvelope* envelope = NULL);
+int8_t playToneOnChannel(uint8_t channel, float frequency, uint8_t volume, float duration_sec = 0, float delay_sec = 0, uint8_t waveform = WAVE_SINE, const AudioEnvelope* envelope = NULL);
+// envelope: attack / decay / sustain / release shape, NULL for a short click free fade in and out
+// Integer versions: MIDI note (69 = A4) or whole Hz, durations in ticks (1/240 s, see notetables.h)
+// No floating point math, tables are built at compile time for TONE_SAMPLE_RATE
+int8_t playNote(uint8_t note, uint8_t volume, uint8_t duration_ticks = 0, uint8_t delay_ticks = 0, uint8_t priority = AUDIO_PRIORITY_NORMAL, uint8_t waveform = WAVE_SINE, const AudioEnvelope* envelope = NULL);
+int8_t playToneHz(uint16_t frequency, uint8_t volume, uint8_t duration_ticks = 0, uint8_t delay_ticks = 0, uint8_t priority = AUDIO_PRIORITY_NORMAL, uint8_t waveform = WAVE_SINE, const AudioEnvelope* envelope = NULL);
+// ADPCM sample clips (see AudioSample), pitch AUDIO_PITCH_NORMAL plays at the recorded rate
+int8_t playSample(const AudioSample* sample, uint8_t volume, uint32_t pitch = AUDIO_PITCH_NORMAL, uint8_t priority = AUDIO_PRIORITY_NORMAL, int8_t pan = 0);
+void setChannelVolume(int8_t channel, uint8_t volume);
+void setChannelPan(int8_t channel, int8_t pan);   // -127 left, 0 center, 127 right
+// Tones played between these two calls share the same start, delays stay sample exact
+void beginToneGroup();
+void endToneGroup();
+void stopChannel(int8_t channel);
+void stopAllTones();
+void cancelScheduled(int8_t channel);
+
+// Query functions
+uint8_t getMaxChannels();
+int8_t findFreeChannel();
+bool isChannelActive(int8_t channel);
+uint8_t getActiveChannelCount();
+uint8_t getPlayingChannelCount();
+#endif
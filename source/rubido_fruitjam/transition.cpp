@@ -0,0 +1,135 @@
+// transition.cpp - full screen fades and wipes between scenes
+// Per frame alphas and wipe positions are precomputed when a transition begins,
+// the per frame work is only the blend / copy of the pixels that need it
+
+#include "transition.h"
+#include "tween.h"
+
+static Framebuffer* snapshot = NULL;         // copy of the last frame of the outgoing scene
+static uint8_t transition_type = TRANSITION_NONE;
+static uint8_t frame_count = 0;
+static uint8_t current_frame = 0;
+static uint8_t alpha_table[MAX_TRANSITION_FRAMES];     // incoming scene alpha (0-32) per frame
+static int16_t edge_table[MAX_TRANSITION_FRAMES];      // wipe edge position per frame
+static uint8_t edge_alpha_table[TRANSITION_WIPE_EDGE]; // incoming scene alpha across the soft edge
+
+bool transitionBegin(Framebuffer* outgoing, uint8_t type, uint8_t frames) {
+    if (!outgoing || !outgoing->buffer || type == TRANSITION_NONE || frames == 0) {
+        transitionCancel();
+        return false;
+    }
+    if (frames > MAX_TRANSITION_FRAMES) frames = MAX_TRANSITION_FRAMES;
+
+    if (!snapshot) {
+        snapshot = createFramebuffer(outgoing->width, outgoing->height, outgoing->littleEndian, outgoing->bgr);
+        if (!snapshot) {
+            transition_type = TRANSITION_NONE;
+            return false;
+        }
+    }
+    memcpy(snapshot->buffer, outgoing->buffer, (size_t)outgoing->width * outgoing->height * sizeof(uint16_t));
+
+    int16_t size = (type == TRANSITION_WIPE_DOWN) ? outgoing->height : outgoing->width;
+    for (uint8_t i = 0; i < frames; i++) {
+        uint16_t eased = tweenEase(EASE_IN_OUT, (uint16_t)(((uint32_t)(i + 1) * 32768) / frames));
+        alpha_table[i] = (uint8_t)(((uint32_t)eased * 32 + 16384) >> 15);
+        // run the edge past the end of the screen so the soft edge leaves as well
+        edge_table[i] = (int16_t)(((int32_t)(size + TRANSITION_WIPE_EDGE) * eased) >> 15);
+    }
+    for (uint8_t i = 0; i < TRANSITION_WIPE_EDGE; i++) {
+        edge_alpha_table[i] = (uint8_t)(32 - ((i + 1) * 32) / (TRANSITION_WIPE_EDGE + 1));
+    }
+
+    transition_type = type;
+    frame_count = frames;
+    current_frame = 0;
+    return true;
+}
+
+static void transitionWipeLeft(Framebuffer* fb, int16_t edge) {
+    int16_t band = edge - TRANSITION_WIPE_EDGE;
+    for (int16_t y = 0; y < fb->height; y++) {
+        uint16_t* dest = fb->buffer + y * fb->width;
+        uint16_t* src = snapshot->buffer + y * fb->width;
+        // soft edge, incoming scene fades out towards the outgoing one
+        for (int16_t i = 0; i < TRANSITION_WIPE_EDGE; i++) {
+            int16_t x = band + i;
+            if (x >= 0 && x < fb->width)
+                dest[x] = blend565(dest[x], src[x], edge_alpha_table[i]);
+        }
+        // rest of the row still shows the outgoing scene
+        if (edge < fb->width) {
+            int16_t start = edge < 0 ? 0 : edge;
+            memcpy(dest + start, src + start, (fb->width - start) * sizeof(uint16_t));
+        }
+    }
+}
+
+static void transitionWipeDown(Framebuffer* fb, int16_t edge) {
+    int16_t band = edge - TRANSITION_WIPE_EDGE;
+    for (int16_t i = 0; i < TRANSITION_WIPE_EDGE; i++) {
+        int16_t y = band + i;
+        if (y >= 0 && y < fb->height) {
+            uint16_t* row = fb->buffer + y * fb->width;
+            blendSpan565(row, row, snapshot->buffer + y * fb->width, fb->width, edge_alpha_table[i]);
+        }
+    }
+    if (edge < fb->height) {
+        int16_t start = edge < 0 ? 0 : edge;
+        memcpy(fb->buffer + start * fb->width, snapshot->buffer + start * fb->width,
+               (size_t)(fb->height - start) * fb->width * sizeof(uint16_t));
+    }
+}
+
+// Call after the incoming scene drew its frame into fb
+void transitionApply(Framebuffer* fb) {
+    if (transition_type == TRANSITION_NONE || !snapshot) return;
+    if (!fb || !fb->buffer || fb->width != snapshot->width || fb->height != snapshot->height) {
+        transitionCancel();
+        return;
+    }
+
+    int32_t pixels = (int32_t)fb->width * fb->height;
+    uint8_t alpha = alpha_table[current_frame];
+
+    switch (transition_type) {
+        case TRANSITION_CROSSFADE:
+            blendSpan565(fb->buffer, fb->buffer, snapshot->buffer, pixels, alpha);
+            break;
+
+        case TRANSITION_FADE_BLACK:
+            // first half fades the outgoing scene out, second half the incoming scene in
+            if (alpha <= 16)
+                blendSpanColor565(fb->buffer, snapshot->buffer, 0, pixels, 32 - alpha * 2);
+            else
+                blendSpanColor565(fb->buffer, fb->buffer, 0, pixels, alpha * 2 - 32);
+            break;
+
+        case TRANSITION_WIPE_LEFT:
+            transitionWipeLeft(fb, edge_table[current_frame]);
+            break;
+
+        case TRANSITION_WIPE_DOWN:
+            transitionWipeDown(fb, edge_table[current_frame]);
+            break;
+    }
+
+    current_frame++;
+    if (current_frame >= frame_count)
+        transitionCancel();
+}
+
+// Stop the transition and give the snapshot memory back
+void transitionCancel() {
+    transition_type = TRANSITION_NONE;
+    frame_count = 0;
+    current_frame = 0;
+    if (snapshot) {
+        destroyFramebuffer(snapshot);
+        snapshot = NULL;
+    }
+}
+
+bool transitionIsActive() {
+    return transition_type != TRANSITION_NONE;
+}
@@ -0,0 +1,34 @@
+#ifndef TRANSITION_H
+#define TRANSITION_H
+
+#include <stdint.h>
+#include "framebuffer.h"
+
+// Configuration
+#ifndef MAX_TRANSITION_FRAMES
+#define MAX_TRANSITION_FRAMES 32
+#endif
+#define TRANSITION_WIPE_EDGE 8  // width in pixels of the soft edge of a wipe
+
+// Full screen transitions between the outgoing and incoming scene
+// Typical usage:
+//   transitionBegin(&fb, TRANSITION_CROSSFADE, 12);  // after the last frame of the old scene was drawn
+//   ... next frames, after the new scene drew itself:
+//   if (transitionIsActive())
+//     transitionApply(&fb);
+// Beginning a transition takes a copy of the outgoing frame, if there is not
+// enough memory for it the scenes just cut like before
+
+enum TransitionType {
+    TRANSITION_NONE,
+    TRANSITION_CROSSFADE,    // blend from the outgoing to the incoming scene
+    TRANSITION_FADE_BLACK,   // fade the outgoing scene to black, then the incoming scene in
+    TRANSITION_WIPE_LEFT,    // incoming scene slides in from the left over the outgoing one
+    TRANSITION_WIPE_DOWN     // incoming scene slides in from the top over the outgoing one
+};
+
+bool transitionBegin(Framebuffer* outgoing, uint8_t type, uint8_t frames);
+void transitionApply(Framebuffer* fb);
+void transitionCancel();
+bool transitionIsActive();
+#endif
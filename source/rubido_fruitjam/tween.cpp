@@ -0,0 +1,99 @@
+// tween.cpp - fixed point tweening with a preallocated pool
+// Easing curves are 33 entry Q15 tables, linearly interpolated (no float in the frame loop)
+
+#include "tween.h"
+
+static Tween tweens[MAX_TWEENS];
+
+// curve(t) for t = 0/32 .. 32/32, Q15
+static const uint16_t ease_in_lut[33] = {
+    0, 32, 128, 288, 512, 800, 1152, 1568, 2048, 2592, 3200, 3872, 4608, 5408, 6272, 7200,
+    8192, 9248, 10368, 11552, 12800, 14112, 15488, 16928, 18432, 20000, 21632, 23328, 25088, 26912, 28800, 30752,
+    32768
+};
+
+static const uint16_t ease_out_lut[33] = {
+    0, 2016, 3968, 5856, 7680, 9440, 11136, 12768, 14336, 15840, 17280, 18656, 19968, 21216, 22400, 23520,
+    24576, 25568, 26496, 27360, 28160, 28896, 29568, 30176, 30720, 31200, 31616, 31968, 32256, 32480, 32640, 32736,
+    32768
+};
+
+static const uint16_t ease_in_out_lut[33] = {
+    0, 94, 368, 810, 1408, 2150, 3024, 4018, 5120, 6318, 7600, 8954, 10368, 11830, 13328, 14850,
+    16384, 17918, 19440, 20938, 22400, 23814, 25168, 26450, 27648, 28750, 29744, 30618, 31360, 31958, 32400, 32674,
+    32768
+};
+
+uint16_t tweenEase(uint8_t easing, uint16_t progress) {
+    const uint16_t* lut;
+    switch (easing) {
+        case EASE_IN: lut = ease_in_lut; break;
+        case EASE_OUT: lut = ease_out_lut; break;
+        case EASE_IN_OUT: lut = ease_in_out_lut; break;
+        default: return progress;
+    }
+    if (progress >= 32768) return 32768;
+
+    // 5 bits table index, 10 bits interpolation
+    uint16_t index = progress >> 10;
+    uint16_t frac = progress & 0x3FF;
+    int32_t a = lut[index];
+    int32_t b = lut[index + 1];
+    return (uint16_t)(a + (((b - a) * frac) >> 10));
+}
+
+int8_t tweenStart(int16_t from, int16_t to, uint16_t frames, uint8_t easing) {
+    for (int8_t i = 0; i < MAX_TWEENS; i++) {
+        if (!tweens[i].active) {
+            if (frames == 0) frames = 1;
+            tweens[i].from = from;
+            tweens[i].to = to;
+            tweens[i].value = from;
+            tweens[i].progress = 0;
+            tweens[i].step = (32768 + frames - 1) / frames;
+            tweens[i].easing = easing < EASE_COUNT ? easing : (uint8_t)EASE_LINEAR;
+            tweens[i].active = true;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Advance all running tweens by one frame, a tween stays readable (value == to)
+// for the frame it finishes on
+void tweenUpdateAll() {
+    for (int i = 0; i < MAX_TWEENS; i++) {
+        Tween* t = &tweens[i];
+        if (!t->active) continue;
+
+        if (t->progress >= 32768) {
+            t->active = false;
+            continue;
+        }
+
+        uint32_t progress = t->progress + t->step;
+        if (progress >= 32768) {
+            t->progress = 32768;
+            t->value = t->to;
+            continue;
+        }
+        t->progress = progress;
+        int32_t delta = (int32_t)t->to - t->from;
+        t->value = t->from + ((delta * tweenEase(t->easing, t->progress)) >> 15);
+    }
+}
+
+void tweenStop(int8_t id) {
+    if (id >= 0 && id < MAX_TWEENS)
+        tweens[id].active = false;
+}
+
+bool tweenIsActive(int8_t id) {
+    if (id < 0 || id >= MAX_TWEENS) return false;
+    return tweens[id].active;
+}
+
+int16_t tweenGetValue(int8_t id) {
+    if (id < 0 || id >= MAX_TWEENS) return 0;
+    return tweens[id].value;
+}
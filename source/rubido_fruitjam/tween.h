@@ -0,0 +1,43 @@
+#ifndef TWEEN_H
+#define TWEEN_H
+
+#include <stdint.h>
+
+// Configuration
+#ifndef MAX_TWEENS
+#define MAX_TWEENS 8
+#endif
+
+// Fixed point tweening, all math is integer (progress is Q15: 0 - 32768)
+// Tweens advance one step per rendered frame, call tweenUpdateAll() once per frame
+// Typical usage:
+//   int8_t t = tweenStart(10, 58, 12, EASE_IN_OUT);  // from 10 to 58 in 12 frames
+//   ...
+//   tweenUpdateAll();
+//   x = tweenGetValue(t);
+
+enum TweenEasing {
+    EASE_LINEAR,
+    EASE_IN,        // quadratic, slow start
+    EASE_OUT,       // quadratic, slow end
+    EASE_IN_OUT,    // smoothstep
+    EASE_COUNT
+};
+
+struct Tween {
+    int16_t from;
+    int16_t to;
+    int16_t value;
+    uint16_t progress;  // Q15
+    uint16_t step;      // Q15 progress per frame
+    uint8_t easing;
+    bool active;
+};
+
+int8_t tweenStart(int16_t from, int16_t to, uint16_t frames, uint8_t easing);
+void tweenUpdateAll();
+void tweenStop(int8_t id);
+bool tweenIsActive(int8_t id);
+int16_t tweenGetValue(int8_t id);
+uint16_t tweenEase(uint8_t easing, uint16_t progress);
+#endif
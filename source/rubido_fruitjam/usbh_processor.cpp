@@ -1,3 +1,4 @@
+#include <string.h>
 #include "Adafruit_TinyUSB.h"
 #include "tusb.h"
 #include "usbh_processor.h"
@@ -56,33 +57,188 @@ GamePadReport GamePadConfigs[] = {
     {34918,2341,2,0x00,false,2,0xFF,false,3,0x00,false,3,0xFF,false,0,0x04,true,0,0x02,true,0,0x08,true,0,0x01,true,0,0x40,true,0,0x80,true,1,0xf2,false,1,0xf1,false},
 };
 
-volatile bool keyboardKeys[0xFF];
-volatile bool prev_keyboardKeys[0xFF];
-volatile bool curr_keyboardKeys[0xFF];
-volatile uint8_t mouseButtons;
-volatile uint8_t curr_mouseButtons;
-volatile uint8_t prev_mouseButtons;
-volatile int16_t mousex = 0;
-volatile int16_t mousey = 0;
-volatile int16_t mouseRangeMinX = 0;
-volatile int16_t mouseRangeMinY = 0;
-volatile int16_t mouseRangeMaxX = 0;
-volatile int16_t mouseRangeMaxY = 0;
-volatile uint32_t joystickButtons = 0;
-volatile uint32_t prev_joystickButtons = 0;
-volatile uint32_t curr_joystickButtons = 0;
+// Input events, written by the TinyUSB callbacks on core1 and drained by
+// updateUSBHButtons() on core0. Single producer / single consumer: the head is
+// only written by core1, the tail only by core0, so neither side ever waits.
+// All state the game reads is built from the events on core0, a key that goes
+// down and up again between two frames still counts as just pressed.
+//
+// Mouse and gamepad reports keep coming while nothing changes, so a new report is
+// merged into the last event of its type while core0 has not taken it yet: deltas
+// add up, the newest mask wins and presses collect in pressed. That leaves at most
+// two of each in the queue and USBH_INPUT_RESERVED_SLOTS keeps room for them.
+// Key edges are never merged. One that finds the queue full is not lost either:
+// core1 keeps its own key bitset and core0 catches up from it after draining.
+#define USBH_INPUT_RESERVED_SLOTS 4   // only mouse and gamepad events may use these
+
+enum {
+    USBH_EVENT_KEY_DOWN,
+    USBH_EVENT_KEY_UP,
+    USBH_EVENT_GAMEPAD,         // buttons is the newest mask
+    USBH_EVENT_MOUSE            // buttons, dx and dy summed over the merged reports
+};
+
+// claim on a queued event, core1 may only merge into an open one
+enum {
+    USBH_SLOT_OPEN,
+    USBH_SLOT_MERGING,          // core1 is adding a report, core0 waits the few cycles it takes
+    USBH_SLOT_TAKEN             // core0 is reading it
+};
+
+typedef struct
+{
+    uint32_t time_us;           // micros() of the report, of the first press for merged events
+    uint32_t claim;
+    uint8_t type;
+    uint8_t key;
+    int16_t dx;
+    int16_t dy;
+    uint32_t buttons;
+    uint32_t pressed;           // buttons that went down in the merged reports
+} UsbhInputEvent;
+
+static UsbhInputEvent input_events[USBH_INPUT_QUEUE_SIZE];
+static uint32_t input_event_head = 0;      // core1
+static uint32_t input_event_tail = 0;      // core0
+static volatile uint32_t dropped_input_events = 0;
+
+// core1 only, from the TinyUSB callbacks
+static uint32_t report_time_us = 0;        // set when a report comes in
+static uint32_t mouse_event_slot = 0;      // queue index of the last mouse / gamepad event
+static uint32_t gamepad_event_slot = 0;
+static bool mouse_event_queued = false;
+static bool gamepad_event_queued = false;
+static uint8_t core1_mouseButtons = 0;
+static uint32_t core1_joystickButtons = 0;
+
+// key state as core1 sees it and presses that did not fit in the queue,
+// core0 reads them once keys_overflowed is set
+static UsbhKeySet core1_keyboardKeys;
+static UsbhKeySet dropped_keyPresses;
+static bool keys_overflowed = false;
+
+// core0 state, built from the events. Keys are bitsets, key n is bit n % 32 of word n / 32
+static UsbhKeySet curr_keyboardKeys;
+static UsbhKeySet prev_keyboardKeys;        // at the previous update
+static UsbhKeySet pressed_keyboardKeys;     // went down since the previous update
+static UsbhKeySet released_keyboardKeys;    // went up since the previous update
+static uint8_t curr_mouseButtons = 0;
+static uint8_t pressed_mouseButtons = 0;
+static uint32_t curr_joystickButtons = 0;
+static uint32_t pressed_joystickButtons = 0;
+static int16_t mousex = 0;
+static int16_t mousey = 0;
+static int16_t mouseRangeMinX = 0;
+static int16_t mouseRangeMinY = 0;
+static int16_t mouseRangeMaxX = 0;
+static int16_t mouseRangeMaxY = 0;
+static bool inputChanged = false;
+// earliest press applied by the last update, for the input latency
+static uint32_t keyboard_press_us = 0;
+static uint32_t gamepad_press_us = 0;
+static bool keyboard_pressed = false;
+static bool gamepad_pressed = false;
 
 onKeyboardKeyDownUpCallback keyboardUpDownCallback = NULL;
 
+static inline uint32_t keyBit(uint8_t key)
+{
+    return 1u << (key & 31);
+}
+
+static inline int16_t addDelta(int16_t sum, int8_t delta)
+{
+    int32_t value = sum + delta;
+    return value > INT16_MAX ? INT16_MAX : (value < INT16_MIN ? INT16_MIN : value);
+}
+
+// core1, false when fewer than room slots are free
+static bool pushInputEvent(uint8_t type, uint8_t key, uint32_t buttons, uint32_t pressed, int8_t dx, int8_t dy, uint32_t room)
+{
+    uint32_t head = input_event_head;
+    if (head - __atomic_load_n(&input_event_tail, __ATOMIC_ACQUIRE) >= room)
+        return false;
+    UsbhInputEvent* event = &input_events[head % USBH_INPUT_QUEUE_SIZE];
+    event->time_us = report_time_us;
+    event->claim = USBH_SLOT_OPEN;
+    event->type = type;
+    event->key = key;
+    event->dx = dx;
+    event->dy = dy;
+    event->buttons = buttons;
+    event->pressed = pressed;
+    __atomic_store_n(&input_event_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// core1, key edges leave the reserved slots alone and fall back on the key bitset
+static void pushKeyEvent(uint8_t key, bool down)
+{
+    uint32_t* word = &core1_keyboardKeys.words[key >> 5];
+    uint32_t keys = down ? (*word | keyBit(key)) : (*word & ~keyBit(key));
+    __atomic_store_n(word, keys, __ATOMIC_RELAXED);
+
+    if (pushInputEvent(down ? USBH_EVENT_KEY_DOWN : USBH_EVENT_KEY_UP, key, 0, 0, 0, 0,
+                       USBH_INPUT_QUEUE_SIZE - USBH_INPUT_RESERVED_SLOTS))
+        return;
+    if (down)
+        __atomic_fetch_or(&dropped_keyPresses.words[key >> 5], keyBit(key), __ATOMIC_RELAXED);
+    dropped_input_events = dropped_input_events + 1;
+    __atomic_store_n(&keys_overflowed, true, __ATOMIC_RELEASE);
+}
+
+// core1, merges into the last event of the type while core0 has not taken it
+static void pushOrMergeInputEvent(uint8_t type, uint32_t* slot, bool* queued, uint32_t buttons, uint32_t pressed, int8_t dx, int8_t dy)
+{
+    // the slot is only reused after core0 took it, so while it is at or past the
+    // tail it still holds this event
+    if (*queued && (int32_t)(*slot - __atomic_load_n(&input_event_tail, __ATOMIC_ACQUIRE)) >= 0)
+    {
+        UsbhInputEvent* event = &input_events[*slot % USBH_INPUT_QUEUE_SIZE];
+        uint32_t open = USBH_SLOT_OPEN;
+        if (__atomic_compare_exchange_n(&event->claim, &open, USBH_SLOT_MERGING, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            if (pressed && !event->pressed)
+                event->time_us = report_time_us;
+            event->pressed |= pressed;
+            event->buttons = buttons;
+            event->dx = addDelta(event->dx, dx);
+            event->dy = addDelta(event->dy, dy);
+            __atomic_store_n(&event->claim, USBH_SLOT_OPEN, __ATOMIC_RELEASE);
+            return;
+        }
+    }
+    uint32_t head = input_event_head;
+    if (pushInputEvent(type, 0, buttons, pressed, dx, dy, USBH_INPUT_QUEUE_SIZE))
+    {
+        *slot = head;
+        *queued = true;
+    }
+    else
+        dropped_input_events = dropped_input_events + 1;
+}
+
 void setKeyDownUpCallBack(onKeyboardKeyDownUpCallback callback)
 {
     keyboardUpDownCallback = callback;
 }
 
+static void clampMouse()
+{
+    if (mousex < mouseRangeMinX) 
+        mousex = mouseRangeMinX;
+    if (mousex > mouseRangeMaxX) 
+        mousex = mouseRangeMaxX;
+    if (mousey < mouseRangeMinY) 
+        mousey = mouseRangeMinY;
+    if (mousey > mouseRangeMaxY) 
+        mousey = mouseRangeMaxY;
+}
+
 void setMouseRange(int16_t minx, int16_t miny, int16_t w, int16_t h)
 {
     mouseRangeMinX = minx;
-    mouseRangeMinX = miny;
+    mouseRangeMinY = miny;
     mouseRangeMaxX = minx + w;
     mouseRangeMaxY = miny + h;
 }
@@ -91,14 +247,7 @@ void setMouse(int16_t x, int16_t y)
 {
     mousex = x;
     mousey = y;
-    if (mousex < mouseRangeMinX) 
-        mousex = mouseRangeMinX;
-    if (mousex > mouseRangeMaxX) 
-        mousex = mouseRangeMaxX;
-    if (mousey < mouseRangeMinY) 
-        mousey = mouseRangeMinY;
-    if (mousey > mouseRangeMaxY) 
-        mousey = mouseRangeMaxY;
+    clampMouse();
 }
 
 int16_t getMouseX()
@@ -111,24 +260,155 @@ int16_t getMouseY()
     return mousey;
 }
 
-void updateUSBHButtons()
+static void applyInputEvent(const UsbhInputEvent* event)
+{
+    switch (event->type)
+    {
+        // after an overflow core0 may already have caught up with an edge still queued
+        case USBH_EVENT_KEY_DOWN:
+            if (curr_keyboardKeys.words[event->key >> 5] & keyBit(event->key))
+                break;
+            curr_keyboardKeys.words[event->key >> 5] |= keyBit(event->key);
+            pressed_keyboardKeys.words[event->key >> 5] |= keyBit(event->key);
+            if (!keyboard_pressed)
+                keyboard_press_us = event->time_us;
+            keyboard_pressed = true;
+            if(keyboardUpDownCallback)
+                keyboardUpDownCallback(event->key, true);
+            break;
+
+        case USBH_EVENT_KEY_UP:
+            if (!(curr_keyboardKeys.words[event->key >> 5] & keyBit(event->key)))
+                break;
+            curr_keyboardKeys.words[event->key >> 5] &= ~keyBit(event->key);
+            released_keyboardKeys.words[event->key >> 5] |= keyBit(event->key);
+            if(keyboardUpDownCallback)
+                keyboardUpDownCallback(event->key, false);
+            break;
+
+        case USBH_EVENT_GAMEPAD:
+            if ((event->buttons != curr_joystickButtons) || event->pressed)
+                inputChanged = true;
+            if (event->pressed && !gamepad_pressed)
+            {
+                gamepad_press_us = event->time_us;
+                gamepad_pressed = true;
+            }
+            pressed_joystickButtons |= event->pressed;
+            curr_joystickButtons = event->buttons;
+            break;
+
+        case USBH_EVENT_MOUSE:
+            if ((event->buttons != curr_mouseButtons) || event->pressed)
+                inputChanged = true;
+            pressed_mouseButtons |= event->pressed;
+            curr_mouseButtons = event->buttons;
+            mousex += event->dx;
+            mousey += event->dy;
+            clampMouse();
+            break;
+    }
+}
+
+static void callKeyCallback(int word, uint32_t bits, bool keydown)
 {
-    prev_joystickButtons = curr_joystickButtons;
-    curr_joystickButtons = joystickButtons;
+    for (; bits; bits &= bits - 1)
+        keyboardUpDownCallback((word << 5) + __builtin_ctz(bits), keydown);
+}
 
-    prev_mouseButtons = curr_mouseButtons;
-    curr_mouseButtons = mouseButtons;
+// Key edges that did not fit in the queue: take the keys from core1's own bitset.
+// Edges still queued behind it are applied later and change nothing then.
+// A dropped press of a key that was down here was released first, so those
+// keys go up, down and (when core1 has them up now) up again
+static void catchUpKeyboardKeys()
+{
+    for (int i = 0; i < USBH_KEY_WORDS; i++)
+    {
+        uint32_t keys = __atomic_load_n(&core1_keyboardKeys.words[i], __ATOMIC_RELAXED);
+        uint32_t taps = __atomic_exchange_n(&dropped_keyPresses.words[i], 0, __ATOMIC_RELAXED);
+        uint32_t was = curr_keyboardKeys.words[i];
+        uint32_t upFirst = was & (taps | ~keys);
+        uint32_t down = taps | (keys & ~was);
+        uint32_t upAfter = taps & ~keys;
+        pressed_keyboardKeys.words[i] |= down;
+        released_keyboardKeys.words[i] |= upFirst | upAfter;
+        curr_keyboardKeys.words[i] = keys;
+        if (keyboardUpDownCallback)
+        {
+            callKeyCallback(i, upFirst, false);
+            callKeyCallback(i, down, true);
+            callKeyCallback(i, upAfter, false);
+        }
+    }
+}
 
-    for(int i = 0; i < 0xFF; i++)
+// Applies everything core1 queued since the previous call, once per frame on core0
+void updateUSBHButtons()
+{
+    inputChanged = false;
+    prev_keyboardKeys = curr_keyboardKeys;
+    memset(&pressed_keyboardKeys, 0, sizeof(pressed_keyboardKeys));
+    memset(&released_keyboardKeys, 0, sizeof(released_keyboardKeys));
+    pressed_mouseButtons = 0;
+    pressed_joystickButtons = 0;
+    keyboard_pressed = false;
+    gamepad_pressed = false;
+
+    uint32_t tail = input_event_tail;
+    uint32_t head = __atomic_load_n(&input_event_head, __ATOMIC_ACQUIRE);
+    while (tail != head)
     {
-        prev_keyboardKeys[i] = curr_keyboardKeys[i];
-        curr_keyboardKeys[i] = keyboardKeys[i];
+        UsbhInputEvent* event = &input_events[tail % USBH_INPUT_QUEUE_SIZE];
+        uint32_t open = USBH_SLOT_OPEN;
+        while (!__atomic_compare_exchange_n(&event->claim, &open, USBH_SLOT_TAKEN, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            open = USBH_SLOT_OPEN;   // core1 is merging a report into it
+        applyInputEvent(event);
+        tail++;
     }
+    __atomic_store_n(&input_event_tail, tail, __ATOMIC_RELEASE);
+
+    // after the queue, so the edges left in it are newer than what it catches up to
+    if (__atomic_exchange_n(&keys_overflowed, false, __ATOMIC_ACQUIRE))
+        catchUpKeyboardKeys();
+
+    // a key that went down and up again between two updates changed nothing
+    // from frame to frame but still has to be seen
+    uint32_t keysChanged = 0;
+    for (int i = 0; i < USBH_KEY_WORDS; i++)
+        keysChanged |= (curr_keyboardKeys.words[i] ^ prev_keyboardKeys.words[i]) |
+            (pressed_keyboardKeys.words[i] & released_keyboardKeys.words[i]);
+    if (keysChanged)
+        inputChanged = true;
+}
+
+// true when any key, gamepad or mouse button changed state during the last updateUSBHButtons()
+bool usbhInputChanged()
+{
+    return inputChanged;
+}
+
+uint32_t usbhGetDroppedInputEvents()
+{
+    return dropped_input_events;
+}
+
+bool usbhGetKeyboardPressTime(uint32_t* time_us)
+{
+    if (keyboard_pressed)
+        *time_us = keyboard_press_us;
+    return keyboard_pressed;
+}
+
+bool usbhGetGamepadPressTime(uint32_t* time_us)
+{
+    if (gamepad_pressed)
+        *time_us = gamepad_press_us;
+    return gamepad_pressed;
 }
 
 bool gamepadButtonJustPressed(uint32_t button)
 {
-    return ((curr_joystickButtons & button) && !(prev_joystickButtons & button));
+    return pressed_joystickButtons & button;
 }
 
 
@@ -139,7 +419,7 @@ bool gamepadButtonPressed(uint32_t button)
 
 bool mouseButtonJustPressed(uint8_t button)
 {
-    return (curr_mouseButtons & (1 << button)) && !(prev_mouseButtons & (1 << button));
+    return pressed_mouseButtons & (1 << button);
 }
 
 bool mouseButtonPressed(uint8_t button)
@@ -149,12 +429,48 @@ bool mouseButtonPressed(uint8_t button)
 
 bool keyPressed(uint8_t key)
 {
-    return curr_keyboardKeys[key];
+    return curr_keyboardKeys.words[key >> 5] & keyBit(key);
 }
 
 bool keyJustPressed(uint8_t key)
 {
-    return curr_keyboardKeys[key] && !prev_keyboardKeys[key];
+    return pressed_keyboardKeys.words[key >> 5] & keyBit(key);
+}
+
+bool keyJustReleased(uint8_t key)
+{
+    return released_keyboardKeys.words[key >> 5] & keyBit(key);
+}
+
+void getKeysPressed(UsbhKeySet* keys)
+{
+    *keys = curr_keyboardKeys;
+}
+
+// These hold every edge since the previous update, which is cur & ~prev (and
+// prev & ~cur) plus the keys that went down and up again, or up and down, in between
+void getKeysJustPressed(UsbhKeySet* keys)
+{
+    *keys = pressed_keyboardKeys;
+}
+
+void getKeysJustReleased(UsbhKeySet* keys)
+{
+    *keys = released_keyboardKeys;
+}
+
+int popKey(UsbhKeySet* keys)
+{
+    for (int i = 0; i < USBH_KEY_WORDS; i++)
+    {
+        uint32_t word = keys->words[i];
+        if (word)
+        {
+            keys->words[i] = word & (word - 1);
+            return (i << 5) + __builtin_ctz(word);
+        }
+    }
+    return -1;
 }
 
 
@@ -315,6 +631,8 @@ void tuh_hid_umount_cb(uint8_t dev_addr, uint8_t instance)
 // Invoked when received report from device via interrupt endpoint
 void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* report, uint16_t len)
 {
+    // every event from this report carries the time it arrived
+    report_time_us = micros();
     uint8_t const itf_protocol = tuh_hid_interface_protocol(dev_addr, instance);
 
     switch (itf_protocol)
@@ -361,21 +679,13 @@ static void check_mod(int mod, int prev_mod, int mask, int scancode) {
         {
             debug_printf("key down: %s\n", getKeyName(scancode));
             if((scancode < 0xFF) && (scancode > 0))
-            {
-                if(keyboardUpDownCallback)
-                    keyboardUpDownCallback(scancode, true);
-                keyboardKeys[scancode] = true;
-            }
+                pushKeyEvent(scancode, true);
         }
         else
         {
             debug_printf("key up: %s\n", getKeyName(scancode));
             if((scancode < 0xFF) && (scancode > 0))
-            {
-                if(keyboardUpDownCallback)
-                    keyboardUpDownCallback(scancode, false);
-                keyboardKeys[scancode] = false;
-            }
+                pushKeyEvent(scancode, false);
         }
     }
 }
@@ -398,11 +708,7 @@ static void process_kbd_report(hid_keyboard_report_t const *report)
                 // not existed in previous report means the current key is pressed                
                 debug_printf("key down: %s\n", getKeyName(report->keycode[i]));
                 if((report->keycode[i] < 0xFF) && (report->keycode[i] > 0))
-                {
-                    if(keyboardUpDownCallback)
-                        keyboardUpDownCallback(report->keycode[i], true);
-                    keyboardKeys[report->keycode[i]] = true;
-                }
+                    pushKeyEvent(report->keycode[i], true);
             }
         }
         // Check for key depresses (i.e. was present in prev report but not here)
@@ -412,11 +718,7 @@ static void process_kbd_report(hid_keyboard_report_t const *report)
             {                
                 debug_printf("key up: %s\n", getKeyName(prev_report.keycode[i]));
                 if((prev_report.keycode[i] < 0xFF) && (prev_report.keycode[i] > 0))
-                {
-                    if(keyboardUpDownCallback)
-                        keyboardUpDownCallback(prev_report.keycode[i], false);
-                    keyboardKeys[prev_report.keycode[i]] = false;
-                }
+                    pushKeyEvent(prev_report.keycode[i], false);
             }
         }
     }
@@ -432,18 +734,11 @@ static void process_kbd_report(hid_keyboard_report_t const *report)
 static void process_mouse_report(hid_mouse_report_t const * report)
 {
     debug_printf("Mouse report buttons: %d, x:%d y:%d\n", report->buttons, report->x, report->y);
-    if((report->buttons >= 0) && (report->buttons < 0xFF))
-        mouseButtons = report->buttons;
-    mousex += report->x;
-    mousey += report->y;
-    if (mousex < mouseRangeMinX) 
-        mousex = mouseRangeMinX;
-    if (mousex > mouseRangeMaxX) 
-        mousex = mouseRangeMaxX;
-    if (mousey < mouseRangeMinY) 
-        mousey = mouseRangeMinY;
-    if (mousey > mouseRangeMaxY) 
-        mousey = mouseRangeMaxY;
+    // position is clamped on core0 where the range is set
+    if((report->buttons != core1_mouseButtons) || report->x || report->y)
+        pushOrMergeInputEvent(USBH_EVENT_MOUSE, &mouse_event_slot, &mouse_event_queued,
+            report->buttons, report->buttons & ~core1_mouseButtons, report->x, report->y);
+    core1_mouseButtons = report->buttons;
 }
 
 //--------------------------------------------------------------------+
@@ -477,7 +772,11 @@ static void process_joystic_gamepadconfig(uint8_t configindex, const uint8_t *re
     val |= processButton(c->buttonDownReport, c->buttonDownPressedValue, c->buttonDownIsMask, report, GAMEPAD_DOWN);
     val |= processButton(c->buttonLeftReport, c->buttonLeftPressedValue, c->buttonLeftIsMask, report, GAMEPAD_LEFT);
     val |= processButton(c->buttonRightReport, c->buttonRightPressedValue, c->buttonRightIsMask, report, GAMEPAD_RIGHT);
-    joystickButtons = val;
+    // pads report all the time, only changes become events
+    if(val != core1_joystickButtons)
+        pushOrMergeInputEvent(USBH_EVENT_GAMEPAD, &gamepad_event_slot, &gamepad_event_queued,
+            val, val & ~core1_joystickButtons, 0, 0);
+    core1_joystickButtons = val;
 }
 
 static void process_joystick_report(size_t len, const uint8_t *report, uint16_t productId, uint16_t vendorId)
@@ -3,6 +3,24 @@
 
 #include "Adafruit_TinyUSB.h"
 
+// Configuration
+#ifndef USBH_INPUT_QUEUE_SIZE
+#define USBH_INPUT_QUEUE_SIZE 64   // events between two updateUSBHButtons() calls
+#endif
+
+// The USB host runs on core1, its report callbacks turn every key, button and
+// mouse change into a timestamped event in a lock-free queue. updateUSBHButtons()
+// on core0 applies the queued events once per frame, every other function reads
+// the state it built, so the game never sees a half updated report and a press
+// shorter than a frame still shows up in the JustPressed functions.
+// The key down / up callback is called from updateUSBHButtons(), on core0.
+
+// 256 key bitset, key n is bit n % 32 of words[n / 32]
+#define USBH_KEY_WORDS 8
+struct UsbhKeySet {
+    uint32_t words[USBH_KEY_WORDS];
+};
+
 typedef void (*onKeyboardKeyDownUpCallback)(uint8_t scancode,  bool keydown); 
 
 #define GAMEPAD_NONE  0
@@ -24,6 +42,12 @@ bool keyJustPressed(uint8_t key);
 bool mouseButtonJustPressed(uint8_t button);
 bool gamepadButtonJustPressed(uint32_t button);
 void updateUSBHButtons();
+bool usbhInputChanged();
+// events that found the queue full, key edges among them are still applied from core1's key state
+uint32_t usbhGetDroppedInputEvents();
+// micros() of the earliest press the last update applied (report arrival on core1), false when none
+bool usbhGetKeyboardPressTime(uint32_t* time_us);
+bool usbhGetGamepadPressTime(uint32_t* time_us);
 bool gamepadButtonPressed(uint32_t button);
 void setKeyDownUpCallBack(onKeyboardKeyDownUpCallback callback);
 void setMouseRange(int16_t minx, int16_t miny, int16_t w, int16_t h);
@@ -31,6 +55,14 @@ int16_t getMouseX();
 int16_t getMouseY();
 bool mouseButtonPressed(uint8_t button);
 bool keyPressed(uint8_t key);
+bool keyJustReleased(uint8_t key);
+// Whole keyboard at once, for example every key pressed this frame:
+//   UsbhKeySet keys; getKeysJustPressed(&keys);
+//   for (int key = popKey(&keys); key >= 0; key = popKey(&keys)) { ... }
+void getKeysPressed(UsbhKeySet* keys);
+void getKeysJustPressed(UsbhKeySet* keys);
+void getKeysJustReleased(UsbhKeySet* keys);
+int popKey(UsbhKeySet* keys);   // removes and returns the lowest key, -1 when empty
 void USBHidUpdate(Adafruit_USBH_Host *host) ;
 const char* getKeyName(uint8_t key);
 void setMouse(int16_t x, int16_t y);
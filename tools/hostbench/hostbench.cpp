@@ -0,0 +1,402 @@
+// hostbench.cpp - host (linux / pc) benchmarks for the hardware independent parts of rubido
+//
+// Build (from this folder):
+//   g++ -O2 -I../../source/rubido_fruitjam -o hostbench hostbench.cpp ../../source/rubido_fruitjam/framebuffer.cpp ../../source/rubido_fruitjam/tween.cpp ../../source/rubido_fruitjam/transition.cpp ../../source/rubido_fruitjam/audiomixer.cpp ../../source/rubido_fruitjam/soundbank.cpp ../../source/rubido_fruitjam/musicplayer.cpp ../../source/rubido_fruitjam/adpcm.cpp
+// Run:
+//   ./hostbench          runs all benchmarks
+//   ./hostbench blend    only the RGB565 blending benchmark
+//   ./hostbench mixer    only the audio block mixer benchmark
+//   ./hostbench voices   how many voices of each waveform fit in one block period
+//   ./hostbench music    cost of the music player per block, sound effects next to it
+//   ./hostbench samples  ADPCM decode throughput and the cost of a sample voice
+//   ./hostbench latency  start latency, block cost and buffer fill behind a simulated I2S output
+//
+// Numbers are for the host cpu, use them to compare changes against each other
+// not as absolute numbers for the RP2350
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "framebuffer.h"
+#include "transition.h"
+#include "audiomixer.h"
+#include "soundbank.h"
+#include "musicplayer.h"
+#include "musicdata.h"
+#include "adpcm.h"
+
+static double nowSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void fillPattern(Framebuffer* fb, uint32_t seed)
+{
+    for (int32_t i = 0; i < (int32_t)fb->width * fb->height; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        fb->buffer[i] = (uint16_t)(seed >> 16);
+    }
+}
+
+// Checks the 2 pixels per word blend against the 1 pixel reference, then times
+// full screen cross fades and fades to black
+static int benchBlend()
+{
+    const int width = 320, height = 240, frames = 2000;
+    Framebuffer* a = createFramebuffer(width, height, 1, 0);
+    Framebuffer* b = createFramebuffer(width, height, 1, 0);
+    Framebuffer* out = createFramebuffer(width, height, 1, 0);
+    if (!a || !b || !out) return 1;
+    fillPattern(a, 1);
+    fillPattern(b, 2);
+
+    for (uint8_t alpha = 0; alpha <= 32; alpha++)
+    {
+        blendSpan565(out->buffer, a->buffer, b->buffer, width * height, alpha);
+        for (int32_t i = 0; i < width * height; i++)
+            if (out->buffer[i] != blend565(a->buffer[i], b->buffer[i], alpha))
+            {
+                printf("blend: mismatch at pixel %d alpha %d\n", i, alpha);
+                return 1;
+            }
+    }
+
+    double start = nowSeconds();
+    for (int f = 0; f < frames; f++)
+        blendSpan565(out->buffer, a->buffer, b->buffer, width * height, (uint8_t)(f % 31 + 1));
+    double crossfade = nowSeconds() - start;
+
+    start = nowSeconds();
+    for (int f = 0; f < frames; f++)
+        blendSpanColor565(out->buffer, a->buffer, 0, width * height, (uint8_t)(f % 31 + 1));
+    double fade = nowSeconds() - start;
+
+    start = nowSeconds();
+    transitionBegin(a, TRANSITION_CROSSFADE, MAX_TRANSITION_FRAMES);
+    int transitionFrames = 0;
+    while (transitionIsActive())
+    {
+        memcpy(out->buffer, b->buffer, width * height * sizeof(uint16_t));
+        transitionApply(out);
+        transitionFrames++;
+    }
+    double transition = nowSeconds() - start;
+
+    double mpixels = (double)width * height * frames / 1e6;
+    printf("blend: crossfade     %8.1f Mpixels/s\n", mpixels / crossfade);
+    printf("blend: fade to color %8.1f Mpixels/s\n", mpixels / fade);
+    printf("blend: transition    %8.1f frames/s (%d frames, including copy of the incoming frame)\n",
+        transitionFrames / transition, transitionFrames);
+
+    destroyFramebuffer(a);
+    destroyFramebuffer(b);
+    destroyFramebuffer(out);
+    return 0;
+}
+
+static int64_t mixerChecksum = 0;
+static uint32_t mixerSinkBlocks = 0;
+
+static void mixerSink(const int16_t* block, uint32_t bytes)
+{
+    mixerChecksum += block[mixerSinkBlocks % (bytes / sizeof(int16_t))];
+    mixerSinkBlocks++;
+}
+
+// Pulls blocks like the I2S transmit callback does, with a growing number of
+// endless tones, and reports stereo frames mixed per second. Then checks the
+// software clock hands out exactly sample rate frames for irregular time steps.
+static int benchMixer()
+{
+    const uint32_t sampleRate = 44100;
+    const uint32_t blocks = (sampleRate * 20) / AUDIO_BLOCK_FRAMES;  // 20 seconds of audio
+    const int voiceCounts[] = { 0, 1, 4, 8, 16, 32 };
+
+    for (size_t v = 0; v < sizeof(voiceCounts) / sizeof(voiceCounts[0]); v++)
+    {
+        audioMixerInit(sampleRate);
+        for (int i = 0; i < voiceCounts[v]; i++)
+        {
+            float frequency = 220.0f + 55.0f * i;
+            AudioVoiceParams params = { (uint32_t)((frequency * 4294967296.0) / sampleRate), 0, 20, WAVE_SINE, AUDIO_ENVELOPE_DEFAULT, 0 };
+            audioMixerStartVoice((uint8_t)i, &params, 0);
+        }
+
+        double start = nowSeconds();
+        for (uint32_t b = 0; b < blocks; b++)
+            audioMixerPull(mixerSink);
+        double elapsed = nowSeconds() - start;
+
+        double frames = (double)blocks * AUDIO_BLOCK_FRAMES;
+        printf("mixer: %2d voices %8.2f Msamples/s (%6.0fx real time)\n",
+            voiceCounts[v], frames / elapsed / 1e6, frames / elapsed / sampleRate);
+    }
+    printf("mixer: checksum %lld\n", (long long)mixerChecksum);
+
+    // 60 seconds in random steps of up to 20ms, starting just before the microsecond counter wraps
+    audioMixerInit(sampleRate);
+    uint32_t now = 0xFFFFFFFFu - 1000000;
+    uint32_t seed = 3;
+    uint64_t elapsedUs = 0;
+    uint64_t pulled = 0;
+    audioSoftClockStart(now);
+    while (elapsedUs < 60000000ull)
+    {
+        seed = seed * 1664525 + 1013904223;
+        uint32_t step = (seed >> 16) % 20000 + 1;
+        now += step;
+        elapsedUs += step;
+        pulled += audioSoftClockAdvance(now, mixerSink);
+    }
+    uint64_t expected = (elapsedUs * sampleRate / 1000000) / AUDIO_BLOCK_FRAMES;
+    if (pulled != expected)
+    {
+        printf("mixer: software clock pulled %llu blocks, expected %llu\n",
+            (unsigned long long)pulled, (unsigned long long)expected);
+        return 1;
+    }
+    printf("mixer: software clock %llu blocks in %.3f s\n", (unsigned long long)pulled, elapsedUs / 1e6);
+
+    // An output that really runs at 43478 Hz, as I2S does for 44100, pulling with timer jitter:
+    // the rate lock has to find the rate and the correction that puts the pitch back
+    const double outputRate = 43478.0;
+    audioMixerInit(sampleRate);
+    double outputUs = 0;
+    for (uint32_t b = 0; b < (uint32_t)(outputRate * 10) / AUDIO_BLOCK_FRAMES; b++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        outputUs += AUDIO_BLOCK_FRAMES * 1000000.0 / outputRate;
+        audioMixerPull(mixerSink);
+        audioMixerMeasureRate((uint32_t)outputUs + (seed >> 16) % 50);
+    }
+    double correction = (double)audioMixerGetRateCorrection() / AUDIO_RATE_CORRECTION_UNITY;
+    double expectedCorrection = sampleRate / outputRate;
+    printf("mixer: rate lock measured %u Hz, correction %.5f (exact %.5f)\n",
+        audioMixerGetMeasuredRate(), correction, expectedCorrection);
+    if (correction < expectedCorrection * 0.9995 || correction > expectedCorrection * 1.0005)
+        return 1;
+    return 0;
+}
+
+// Times blocks with no voices and with a full set of one waveform, the difference
+// is the cost of a voice. Dividing the block period (128 frames at 44.1 kHz) by it
+// gives how many voices one core could mix in real time, the budget for MAX_CHANNELS.
+static double timeBlocks(int voiceCount, uint8_t waveform, uint32_t blocks)
+{
+    audioMixerInit(44100);
+    for (int i = 0; i < voiceCount; i++)
+    {
+        AudioVoiceParams params = { 0x01000000u + 0x00123456u * i, 0, 200, waveform, AUDIO_ENVELOPE_DEFAULT, 0 };
+        audioMixerStartVoice((uint8_t)i, &params, 0);
+    }
+    audioMixerPull(mixerSink);   // picks up the start commands
+
+    double start = nowSeconds();
+    for (uint32_t b = 0; b < blocks; b++)
+        audioMixerPull(mixerSink);
+    return (nowSeconds() - start) / blocks;
+}
+
+static int benchVoices()
+{
+    const char* names[WAVE_COUNT] = { "sine", "square", "triangle", "saw", "noise" };
+    const uint32_t blocks = 20000;
+    const int voiceCount = MAX_CHANNELS < 32 ? MAX_CHANNELS : 32;
+    const double blockPeriod = (double)AUDIO_BLOCK_FRAMES / 44100;
+
+    double empty = timeBlocks(0, WAVE_SINE, blocks);
+    printf("voices: empty block %6.2f us of %6.2f us block period\n", empty * 1e6, blockPeriod * 1e6);
+    for (uint8_t w = 0; w < WAVE_COUNT; w++)
+    {
+        double perVoice = (timeBlocks(voiceCount, w, blocks) - empty) / voiceCount;
+        printf("voices: %-8s %6.3f us per voice per block, %6.0f voices per block period\n",
+            names[w], perVoice * 1e6, (blockPeriod - empty) / perVoice);
+    }
+    return 0;
+}
+
+static int32_t musicPeak = 0;
+
+static void musicSink(const int16_t* block, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes / sizeof(int16_t); i++)
+        if (abs(block[i]) > musicPeak) musicPeak = abs(block[i]);
+}
+
+// Plays the title music for a minute of audio and reports the player cost per block
+// (nanoseconds here), then checks a sound effect started next to it plays on the
+// next block on a voice of its own
+static int benchMusic()
+{
+    const uint32_t blocks = 60 * 44100 / AUDIO_BLOCK_FRAMES;
+    audioMixerInit(44100);
+    if (!musicPlay(&music_title))
+    {
+        printf("music: no voices for the song\n");
+        return 1;
+    }
+    musicPeak = 0;
+    double start = nowSeconds();
+    for (uint32_t b = 0; b < blocks; b++)
+        audioMixerPull(musicSink);
+    double elapsed = nowSeconds() - start;
+    printf("music: %u blocks in %.3f s, player %u ns per block average, %u ns max, peak %d\n",
+        (unsigned)blocks, elapsed, (unsigned)musicGetBlockCycles(), (unsigned)musicGetMaxBlockCycles(), (int)musicPeak);
+
+    // Drain the ring so the next pull renders a block that picks up the command
+    int8_t voice = soundBankPlay(SOUND_SELECT, 200);
+    for (int i = 0; i <= AUDIO_RING_BLOCKS; i++)
+        audioMixerPull(mixerSink);
+    bool ok = voice >= 0 && musicIsPlaying() && audioMixerGetPlayingCount() >= 1;
+    printf("music: sound effect on voice %d next to the music: %s\n", voice, ok ? "ok" : "FAILED");
+    musicStop();
+    return ok && musicPeak > 0 ? 0 : 1;
+}
+
+// Decodes a second of noise like ADPCM many times over, then times blocks with
+// sample voices at a few pitches against empty blocks, like the voices benchmark
+static int benchSamples()
+{
+    const uint32_t length = 44100;
+    static uint8_t data[44100 / 2];
+    static int16_t decoded[44100];
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < length / 2; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        data[i] = (uint8_t)(seed >> 24);
+    }
+
+    const int rounds = 200;
+    int32_t checksum = 0;
+    double start = nowSeconds();
+    for (int r = 0; r < rounds; r++)
+    {
+        AdpcmState state = { 0, 40 };
+        adpcmDecode(data, 0, length, &state, decoded);
+        checksum += decoded[r % length];
+    }
+    double elapsed = nowSeconds() - start;
+    printf("samples: decode %7.2f Msamples/s (%6.0fx real time at 44.1 kHz), checksum %d\n",
+        rounds * (double)length / elapsed / 1e6, rounds * (double)length / 44100 / elapsed, (int)checksum);
+
+    AudioSample sample = { data, (uint16_t)(length > 65535 ? 65535 : length), 22050, 0, 40 };
+    const uint32_t blocks = 20000;
+    const int voiceCount = MAX_CHANNELS < 16 ? MAX_CHANNELS : 16;
+    const double blockPeriod = (double)AUDIO_BLOCK_FRAMES / 44100;
+    const uint32_t pitches[] = { AUDIO_PITCH_NORMAL / 2, AUDIO_PITCH_NORMAL, AUDIO_PITCH_NORMAL * 2 };
+    double empty = timeBlocks(0, WAVE_SINE, blocks);
+    for (int p = 0; p < 3; p++)
+    {
+        audioMixerInit(44100);
+        // a 22 kHz clip at pitch 2 runs out after about 250 blocks, restart it as needed
+        double total = 0;
+        for (uint32_t b = 0; b < blocks; b += 200)
+        {
+            for (int i = 0; i < voiceCount; i++)
+                audioMixerStartSample((uint8_t)i, &sample, pitches[p], 200, 0, 0);
+            double t = nowSeconds();
+            for (int k = 0; k < 200; k++)
+                audioMixerPull(mixerSink);
+            total += nowSeconds() - t;
+        }
+        double perVoice = (total / blocks - empty) / voiceCount;
+        printf("samples: pitch %4.2f %6.3f us per voice per block, %6.0f voices per block period\n",
+            pitches[p] / 65536.0, perVoice * 1e6, (blockPeriod - empty) / perVoice);
+    }
+    return 0;
+}
+
+// Simulated I2S output: 8 DMA buffers of one block, like AUDIO_BUFFER_SIZE 4096 gives on the
+// Fruit Jam. Every block period one buffer plays out and the transmit callback refills,
+// now and then the callback is held off for a block or two (flash writes, USB).
+static uint32_t simQueuedFrames = 0;
+
+static void simI2SSink(const int16_t* block, uint32_t bytes)
+{
+    (void)block;
+    simQueuedFrames += bytes / (2 * sizeof(int16_t));
+}
+
+static void startLatencyTone()
+{
+    int8_t voice = audioMixerAllocVoice(AUDIO_PRIORITY_NORMAL);
+    AudioVoiceParams params = { 0x02000000u, 2000, 100, WAVE_SINE, AUDIO_ENVELOPE_DEFAULT, 0 };
+    if (voice >= 0) audioMixerStartVoice((uint8_t)voice, &params, 0);
+}
+
+static int benchLatency()
+{
+    const uint32_t buffers = 8;
+    const uint32_t capacity = buffers * AUDIO_BLOCK_FRAMES;
+    const uint32_t blocks = 60 * 44100 / AUDIO_BLOCK_FRAMES;
+    audioMixerInit(44100);
+    audioMixerSetOutputLatency(capacity);
+    simQueuedFrames = capacity;   // primed with silence
+    audioMixerFillRing();
+
+    uint32_t seed = 7;
+    uint32_t held = 0;
+    for (uint32_t b = 0; b < blocks; b++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        if (simQueuedFrames >= AUDIO_BLOCK_FRAMES) simQueuedFrames -= AUDIO_BLOCK_FRAMES;
+        if (held > 0)
+        {
+            held--;
+            continue;
+        }
+        if ((seed >> 16) % 100 == 0) held = 1 + (seed >> 8) % 2;
+        audioMixerRecordOutputFill(simQueuedFrames * 4, capacity * 4);
+        while (capacity - simQueuedFrames >= AUDIO_BLOCK_FRAMES)
+            audioMixerPull(simI2SSink);
+
+        // the game starts a short tone every few blocks, between two callbacks
+        if (b % 7 == 0)
+            startLatencyTone();
+    }
+
+    AudioTimingStats stats;
+    audioMixerGetTimingStats(&stats);
+    printf("latency: %u starts, %u us min, %u avg, %u max (output buffers %.0f us, ring %.0f us)\n",
+        (unsigned)stats.latency_count, (unsigned)stats.latency_min_us, (unsigned)stats.latency_avg_us,
+        (unsigned)stats.latency_max_us, capacity * 1e6 / 44100, AUDIO_RING_BLOCKS * AUDIO_BLOCK_FRAMES * 1e6 / 44100);
+    printf("latency: %u blocks, %u ns min, %u avg, %u max per block\n",
+        (unsigned)stats.block_count, (unsigned)stats.block_cycles_min, (unsigned)stats.block_cycles_avg,
+        (unsigned)stats.block_cycles_max);
+    printf("latency: buffer fill histogram");
+    for (int i = 0; i < AUDIO_FILL_BUCKETS; i++)
+        printf(" %u", (unsigned)stats.fill_histogram[i]);
+    printf("\n");
+
+    // a start can't beat the queued output, nor wait longer than that plus the ring and the block it missed
+    uint32_t lowest = (uint32_t)(capacity * 1e6 / 44100);
+    uint32_t highest = (uint32_t)((capacity + (AUDIO_RING_BLOCKS + 1) * AUDIO_BLOCK_FRAMES) * 1e6 / 44100) + 1;
+    if (stats.latency_count == 0 || stats.latency_min_us < lowest || stats.latency_max_us > highest)
+        return 1;
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    const char* which = argc > 1 ? argv[1] : "all";
+    int result = 0;
+    if (!strcmp(which, "all") || !strcmp(which, "blend"))
+        result |= benchBlend();
+    if (!strcmp(which, "all") || !strcmp(which, "mixer"))
+        result |= benchMixer();
+    if (!strcmp(which, "all") || !strcmp(which, "voices"))
+        result |= benchVoices();
+    if (!strcmp(which, "all") || !strcmp(which, "music"))
+        result |= benchMusic();
+    if (!strcmp(which, "all") || !strcmp(which, "samples"))
+        result |= benchSamples();
+    if (!strcmp(which, "all") || !strcmp(which, "latency"))
+        result |= benchLatency();
+    return result;
+}
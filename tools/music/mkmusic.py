@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+# mkmusic.py - builds musicdata.h from tracker style song files
+#
+# Usage: python3 mkmusic.py [output header] song.txt [song.txt ...]
+# Every song becomes a MusicSong named music_<song name> (see musicplayer.h).
+#
+# Song file:
+#   song <name>
+#   tempo <bpm>  speed <ticks per row>  rows <rows per pattern>  channels <1-4>
+#   restart <order>
+#   instrument <number> <name> <waveform> <volume 0-64> <attack ms> <decay ms> <sustain 0-255> <release ms>
+#   order <pattern> [pattern ...]
+#   pattern <number>
+#   one line per row, cells split by |, each cell: note instrument volume effect
+#     note:       C-4, C#4 (C-4 is middle C), === releases, ... nothing
+#     instrument: hex number or .
+#     volume:     two hex digits (00-40) or ..
+#     effect:     effect and parameter as three hex digits (A0F) or ...
+# Lines starting with # are comments.
+
+import os
+import sys
+
+WAVEFORMS = ["sine", "square", "triangle", "saw", "noise"]
+NOTE_NAMES = {"C": 0, "D": 2, "E": 4, "F": 5, "G": 7, "A": 9, "B": 11}
+MAX_CHANNELS = 4
+CELL_NOTE, CELL_INSTRUMENT, CELL_VOLUME, CELL_EFFECT = 1, 2, 4, 8
+NOTE_OFF = 0xFF
+
+
+class Song:
+    def __init__(self):
+        self.name = None
+        self.tempo = 125
+        self.speed = 6
+        self.rows = 64
+        self.channels = 4
+        self.restart = 0
+        self.instruments = {}     # number: (name, waveform, volume, a, d, s, r)
+        self.orders = []
+        self.patterns = {}        # number: [row cells]
+
+
+def fail(path, line_no, message):
+    sys.exit("%s:%d: %s" % (path, line_no, message))
+
+
+def parse_note(text):
+    if text == "...":
+        return None
+    if text == "===":
+        return NOTE_OFF
+    semitone = NOTE_NAMES[text[0].upper()]
+    if text[1] == "#":
+        semitone += 1
+    note = (int(text[2:]) + 1) * 12 + semitone
+    if note < 0 or note > 127:
+        raise ValueError
+    return note
+
+
+def parse_cell(text):
+    words = text.split()
+    words += ["...", ".", "..", "..."][len(words):]
+    if len(words) != 4:
+        raise ValueError
+    note = parse_note(words[0])
+    instrument = None if words[1] == "." else int(words[1], 16)
+    volume = None if words[2] == ".." else int(words[2], 16)
+    effect = None if words[3] == "..." else (int(words[3][0], 16), int(words[3][1:], 16))
+    if volume is not None and volume > 64:
+        raise ValueError
+    return note, instrument, volume, effect
+
+
+def parse(path):
+    song = Song()
+    pattern = None
+    for line_no, line in enumerate(open(path), 1):
+        text = line.strip()
+        if not text or text.startswith("#"):
+            continue
+        words = text.split()
+        try:
+            if words[0] == "song":
+                song.name = words[1]
+            elif words[0] in ("tempo", "speed", "rows", "channels", "restart"):
+                setattr(song, words[0], int(words[1]))
+            elif words[0] == "instrument":
+                number = int(words[1])
+                if words[3] not in WAVEFORMS:
+                    fail(path, line_no, "unknown waveform " + words[3])
+                song.instruments[number] = (words[2], WAVEFORMS.index(words[3])) + tuple(int(w) for w in words[4:9])
+            elif words[0] == "order":
+                song.orders += [int(w) for w in words[1:]]
+            elif words[0] == "pattern":
+                pattern = song.patterns.setdefault(int(words[1]), [])
+            elif pattern is not None:
+                cells = [parse_cell(c) for c in text.split("|")]
+                if len(cells) > song.channels:
+                    fail(path, line_no, "more cells than channels")
+                cells += [(None, None, None, None)] * (song.channels - len(cells))
+                pattern.append(cells)
+            else:
+                fail(path, line_no, "can't parse: " + text)
+        except (ValueError, KeyError, IndexError):
+            fail(path, line_no, "can't parse: " + text)
+    if sorted(song.instruments) != list(range(1, len(song.instruments) + 1)):
+        sys.exit("%s: instruments must be numbered 1, 2, 3 ..." % path)
+    if not song.name or not song.orders or song.channels > MAX_CHANNELS:
+        sys.exit("%s: needs a name, orders and at most %d channels" % (path, MAX_CHANNELS))
+    for number in song.orders:
+        if number not in song.patterns:
+            sys.exit("%s: order uses missing pattern %d" % (path, number))
+    for number, rows in song.patterns.items():
+        if len(rows) > song.rows:
+            sys.exit("%s: pattern %d has more than %d rows" % (path, number, song.rows))
+        rows += [[(None, None, None, None)] * song.channels] * (song.rows - len(rows))
+    return song
+
+
+def pack_cell(cell):
+    note, instrument, volume, effect = cell
+    flags = 0
+    data = []
+    if note is not None:
+        flags |= CELL_NOTE
+        data.append(note)
+    if instrument is not None:
+        flags |= CELL_INSTRUMENT
+        data.append(instrument)
+    if volume is not None:
+        flags |= CELL_VOLUME
+        data.append(volume)
+    if effect is not None:
+        flags |= CELL_EFFECT
+        data += list(effect)
+    return [flags] + data
+
+
+def hex_lines(data, per_line=16):
+    return ["    " + ", ".join("0x%02X" % b for b in data[i:i + per_line]) + "," for i in range(0, len(data), per_line)]
+
+
+def write_song(f, song):
+    # patterns are numbered densely in the header, in order of their number
+    numbers = sorted(song.patterns)
+    index = dict((n, i) for i, n in enumerate(numbers))
+    offsets = []
+    data = []
+    for number in numbers:
+        offsets.append(len(data))
+        for row in song.patterns[number]:
+            for cell in row:
+                data += pack_cell(cell)
+    if len(data) > 65535:
+        sys.exit("song %s too large" % song.name)
+    instruments = [song.instruments[n] for n in sorted(song.instruments)]
+    name = song.name
+
+    f.write("// %s: %d patterns of %d rows, %d bytes of pattern data\n" % (name, len(numbers), song.rows, len(data)))
+    f.write("static const uint8_t music_%s_orders[] = { %s };\n" % (name, ", ".join(str(index[o]) for o in song.orders)))
+    f.write("static const uint16_t music_%s_patterns[] = { %s };\n" % (name, ", ".join(str(o) for o in offsets)))
+    f.write("static const uint8_t music_%s_pattern_data[] = {\n%s\n};\n" % (name, "\n".join(hex_lines(data))))
+    f.write("static const MusicInstrument music_%s_instruments[] = {\n" % name)
+    for inst_name, waveform, volume, attack, decay, sustain, release in instruments:
+        f.write("    { %d, %d, { %d, %d, %d, %d } },   // %s\n" % (waveform, volume, attack, decay, sustain, release, inst_name))
+    f.write("};\n")
+    f.write("static const MusicSong music_%s = {\n" % name)
+    f.write("    %d, %d, %d, %d, %d, %d, %d,\n" % (song.channels, song.rows, song.speed, song.tempo,
+                                                  len(song.orders), song.restart, len(instruments)))
+    f.write("    music_%s_orders, music_%s_patterns, music_%s_pattern_data, music_%s_instruments\n" % ((name,) * 4))
+    f.write("};\n\n")
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    if len(sys.argv) > 2:
+        out, sources = sys.argv[1], sys.argv[2:]
+    else:
+        out = os.path.join(here, "..", "..", "source", "rubido_fruitjam", "musicdata.h")
+        sources = sys.argv[1:] or [os.path.join(here, "title.txt")]
+    songs = [parse(path) for path in sources]
+    with open(out, "w") as f:
+        f.write("// Generated from: %s by tools/music/mkmusic.py\n\n" % ", ".join(os.path.basename(s) for s in sources))
+        f.write("#ifndef MUSICDATA_H\n#define MUSICDATA_H\n\n")
+        f.write("#include <stdint.h>\n#include \"musicplayer.h\"\n\n")
+        for song in songs:
+            write_song(f, song)
+        f.write("#endif\n")
+
+
+if __name__ == "__main__":
+    main()
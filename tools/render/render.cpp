@@ -0,0 +1,270 @@
+// render.cpp - plays a script of tone api calls through the mixer into a WAV file on the host
+//
+// Build (from this folder):
+//   g++ -O2 -I../../source/rubido_fruitjam -o render render.cpp ../../source/rubido_fruitjam/tones.cpp ../../source/rubido_fruitjam/audiomixer.cpp ../../source/rubido_fruitjam/soundbank.cpp ../../source/rubido_fruitjam/musicplayer.cpp ../../source/rubido_fruitjam/adpcm.cpp
+// Run:
+//   ./render demo.txt out.wav                          render, report the speed and a checksum
+//   ./render demo.txt out.wav --compare golden/demo.wav   and check it sample for sample
+//   ./render demo.txt                                  only render, for timing
+//
+// The output is the sink and the script is the clock: blocks are rendered back to
+// back as fast as the host can, calls are made before the first block at or after
+// their time. Dither and voice allocation start the same way every run, so the same
+// script and mixer give the same file, a mixer change that should not change the
+// sound can be checked against the golden files (golden/<script>.wav).
+//
+// Script, one call per line, times in milliseconds from the start and in order:
+//   <ms> tone <hz> <volume> <seconds> [waveform]       playTone
+//   <ms> note <midi note> <volume> <ticks> [waveform]  playNote
+//   <ms> hz <hz> <volume> <ticks> [waveform]           playToneHz
+//   <ms> sound <id> <volume> [pan]                     soundBankPlay (SoundId number)
+//   <ms> sample pegclick <volume> [pitch %] [pan]      playSample
+//   <ms> music title|stop
+//   <ms> stop                                          stopAllTones
+//   <ms> end                                           length of the render
+// Waveforms: sine square triangle saw noise. Lines starting with # are comments.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "tones.h"
+#include "audiomixer.h"
+#include "soundbank.h"
+#include "musicplayer.h"
+#include "musicdata.h"
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#include "samples/pegclick_ADPCM.h"
+
+#define RENDER_SAMPLE_RATE 44100
+#define RENDER_MAX_LINE 256
+
+static double nowSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint8_t parseWaveform(const char* name)
+{
+    const char* names[WAVE_COUNT] = { "sine", "square", "triangle", "saw", "noise" };
+    for (uint8_t w = 0; w < WAVE_COUNT; w++)
+        if (!strcmp(name, names[w])) return w;
+    return WAVE_SINE;
+}
+
+// Makes one call, false when the line can't be parsed
+static bool runCall(char* line)
+{
+    char* words[8];
+    int count = 0;
+    for (char* word = strtok(line, " \t\r\n"); word && count < 8; word = strtok(NULL, " \t\r\n"))
+        words[count++] = word;
+    if (count < 2) return false;
+
+    const char* call = words[1];
+    if (!strcmp(call, "tone") && count >= 5)
+        playTone((float)atof(words[2]), atoi(words[3]), (float)atof(words[4]), 0, AUDIO_PRIORITY_NORMAL,
+            count > 5 ? parseWaveform(words[5]) : (uint8_t)WAVE_SINE);
+    else if (!strcmp(call, "note") && count >= 5)
+        playNote(atoi(words[2]), atoi(words[3]), atoi(words[4]), 0, AUDIO_PRIORITY_NORMAL,
+            count > 5 ? parseWaveform(words[5]) : (uint8_t)WAVE_SINE);
+    else if (!strcmp(call, "hz") && count >= 5)
+        playToneHz(atoi(words[2]), atoi(words[3]), atoi(words[4]), 0, AUDIO_PRIORITY_NORMAL,
+            count > 5 ? parseWaveform(words[5]) : (uint8_t)WAVE_SINE);
+    else if (!strcmp(call, "sound") && count >= 4)
+        soundBankPlay(atoi(words[2]), atoi(words[3]), AUDIO_PRIORITY_NORMAL, count > 4 ? atoi(words[4]) : 0);
+    else if (!strcmp(call, "sample") && count >= 4 && !strcmp(words[2], "pegclick"))
+        playSample(&pegclick_sample, atoi(words[3]),
+            count > 4 ? (uint32_t)(atof(words[4]) * AUDIO_PITCH_NORMAL / 100) : AUDIO_PITCH_NORMAL,
+            AUDIO_PRIORITY_NORMAL, count > 5 ? atoi(words[5]) : 0);
+    else if (!strcmp(call, "music") && count >= 3 && !strcmp(words[2], "title"))
+        musicPlay(&music_title);
+    else if (!strcmp(call, "music") && count >= 3 && !strcmp(words[2], "stop"))
+        musicStop();
+    else if (!strcmp(call, "stop"))
+        stopAllTones();
+    else
+        return false;
+    return true;
+}
+
+static void writeLE(FILE* f, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        fputc((value >> (8 * i)) & 0xFF, f);
+}
+
+static bool writeWav(const char* path, const int16_t* frames, uint32_t count)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    uint32_t dataBytes = count * 2 * sizeof(int16_t);
+    fwrite("RIFF", 1, 4, f);
+    writeLE(f, 36 + dataBytes, 4);
+    fwrite("WAVEfmt ", 1, 8, f);
+    writeLE(f, 16, 4);
+    writeLE(f, 1, 2);                              // PCM
+    writeLE(f, 2, 2);                              // stereo
+    writeLE(f, RENDER_SAMPLE_RATE, 4);
+    writeLE(f, RENDER_SAMPLE_RATE * 4, 4);
+    writeLE(f, 4, 2);
+    writeLE(f, 16, 2);
+    fwrite("data", 1, 4, f);
+    writeLE(f, dataBytes, 4);
+    // samples are little endian like the host
+    fwrite(frames, sizeof(int16_t), count * 2, f);
+    fclose(f);
+    return true;
+}
+
+// Compares against a golden file written by writeWav, returns the number of differing samples
+static long compareWav(const char* path, const int16_t* frames, uint32_t count)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f)
+    {
+        printf("render: can't open %s\n", path);
+        return -1;
+    }
+    fseek(f, 44, SEEK_SET);
+    long differing = 0;
+    int maxDiff = 0;
+    long first = -1;
+    uint32_t read = 0;
+    int16_t sample;
+    while (fread(&sample, sizeof(sample), 1, f) == 1 && read < count * 2)
+    {
+        int diff = abs(sample - frames[read]);
+        if (diff)
+        {
+            if (first < 0) first = read / 2;
+            differing++;
+            if (diff > maxDiff) maxDiff = diff;
+        }
+        read++;
+    }
+    fclose(f);
+    if (read != count * 2)
+    {
+        printf("render: %s has %u frames, rendered %u\n", path, read / 2, count);
+        return differing + 1;
+    }
+    if (differing)
+        printf("render: %ld samples differ from %s, first at frame %ld, largest by %d\n", differing, path, first, maxDiff);
+    else
+        printf("render: identical to %s\n", path);
+    return differing;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: render script.txt [out.wav] [--compare golden.wav]\n");
+        return 2;
+    }
+    const char* scriptPath = argv[1];
+    const char* outPath = NULL;
+    const char* goldenPath = NULL;
+    for (int i = 2; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--compare") && i + 1 < argc)
+            goldenPath = argv[++i];
+        else
+            outPath = argv[i];
+    }
+
+    FILE* script = fopen(scriptPath, "r");
+    if (!script)
+    {
+        printf("render: can't open %s\n", scriptPath);
+        return 2;
+    }
+    // The whole script is read first, so only the mixer is timed
+    static char lines[1024][RENDER_MAX_LINE];
+    uint32_t times[1024];
+    int lineCount = 0;
+    uint32_t endFrame = 0;
+    int lineNo = 0;
+    while (lineCount < 1024 && fgets(lines[lineCount], RENDER_MAX_LINE, script))
+    {
+        lineNo++;
+        char* text = lines[lineCount];
+        while (*text == ' ' || *text == '\t') text++;
+        if (*text == '#' || *text == '\n' || *text == '\r' || *text == 0) continue;
+        unsigned ms = 0;
+        char call[16] = "";
+        if (sscanf(text, "%u %15s", &ms, call) != 2)
+        {
+            printf("%s:%d: can't parse: %s", scriptPath, lineNo, text);
+            return 2;
+        }
+        uint32_t frame = (uint32_t)((uint64_t)ms * RENDER_SAMPLE_RATE / 1000);
+        if (!strcmp(call, "end"))
+        {
+            endFrame = frame;
+            continue;
+        }
+        if (lineCount > 0 && frame < times[lineCount - 1])
+        {
+            printf("%s:%d: calls have to be in order\n", scriptPath, lineNo);
+            return 2;
+        }
+        times[lineCount++] = frame;
+    }
+    fclose(script);
+    if (endFrame == 0)
+    {
+        printf("%s: needs an end line\n", scriptPath);
+        return 2;
+    }
+
+    uint32_t frameCount = (endFrame + AUDIO_BLOCK_FRAMES - 1) / AUDIO_BLOCK_FRAMES * AUDIO_BLOCK_FRAMES;
+    int16_t* frames = (int16_t*)malloc(frameCount * 2 * sizeof(int16_t));
+    if (!frames) return 2;
+
+    audioMixerInit(RENDER_SAMPLE_RATE);
+    int next = 0;
+    double start = nowSeconds();
+    for (uint32_t frame = 0; frame < frameCount; frame += AUDIO_BLOCK_FRAMES)
+    {
+        // calls made before the block that contains their time
+        while (next < lineCount && times[next] < frame + AUDIO_BLOCK_FRAMES)
+        {
+            if (!runCall(lines[next]))
+            {
+                printf("%s: can't run: %s\n", scriptPath, lines[next]);
+                return 2;
+            }
+            next++;
+        }
+        audioMixerRender(&frames[frame * 2], AUDIO_BLOCK_FRAMES);
+    }
+    double elapsed = nowSeconds() - start;
+
+    // FNV-1a over the samples, the same for the same output on any host
+    uint32_t checksum = 2166136261u;
+    for (uint32_t i = 0; i < frameCount * 2; i++)
+    {
+        checksum = (checksum ^ (uint16_t)frames[i]) * 16777619u;
+    }
+    printf("render: %u frames (%.2f s) in %.4f s, %.2f Msamples/s (%.0fx real time), checksum %08x\n",
+        frameCount, (double)frameCount / RENDER_SAMPLE_RATE, elapsed, frameCount / elapsed / 1e6,
+        frameCount / elapsed / RENDER_SAMPLE_RATE, checksum);
+
+    int result = 0;
+    if (outPath && !writeWav(outPath, frames, frameCount))
+    {
+        printf("render: can't write %s\n", outPath);
+        result = 2;
+    }
+    if (goldenPath && compareWav(goldenPath, frames, frameCount) != 0)
+        result = 1;
+    free(frames);
+    return result;
+}
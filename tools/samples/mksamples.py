@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+# mksamples.py - encodes WAV files as IMA ADPCM sample headers
+#
+# Usage: python3 mksamples.py file.wav [file.wav ...]
+# Writes source/rubido_fruitjam/samples/<name>_ADPCM.h for every file with
+# <name>_data (4 bits per sample, low nibble first) and <name>_sample, an
+# AudioSample (audiomixer.h) for audioMixerStartSample / playSample.
+# Stereo files are mixed to mono, 8 and 16 bit files are accepted, the rate
+# is kept (at most 65535 Hz and 65535 samples).
+
+import os
+import struct
+import sys
+import wave
+
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+]
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def read_wav(path):
+    with wave.open(path, "rb") as w:
+        channels, width, rate, frames = w.getnchannels(), w.getsampwidth(), w.getframerate(), w.getnframes()
+        raw = w.readframes(frames)
+    if width == 1:
+        values = [(b - 128) << 8 for b in raw]
+    elif width == 2:
+        values = list(struct.unpack("<%dh" % (len(raw) // 2), raw))
+    else:
+        sys.exit("%s: only 8 and 16 bit files" % path)
+    mono = [sum(values[i:i + channels]) // channels for i in range(0, len(values), channels)]
+    return rate, mono
+
+
+# Same steps as adpcmDecodeSample, so the encoder tracks the decoder exactly
+def decode_step(predictor, index, nibble):
+    step = STEP_TABLE[index]
+    diff = step >> 3
+    if nibble & 4:
+        diff += step
+    if nibble & 2:
+        diff += step >> 1
+    if nibble & 1:
+        diff += step >> 2
+    predictor = predictor - diff if nibble & 8 else predictor + diff
+    predictor = max(-32768, min(32767, predictor))
+    index = max(0, min(88, index + INDEX_TABLE[nibble & 7]))
+    return predictor, index
+
+
+def encode_from(samples, start_index):
+    predictor, index = samples[0], start_index
+    start = (predictor, index)
+    nibbles = []
+    error = 0
+    for sample in samples:
+        step = STEP_TABLE[index]
+        diff = sample - predictor
+        nibble = 0
+        if diff < 0:
+            nibble = 8
+            diff = -diff
+        if diff >= step:
+            nibble |= 4
+            diff -= step
+        if diff >= step >> 1:
+            nibble |= 2
+            diff -= step >> 1
+        if diff >= step >> 2:
+            nibble |= 1
+        predictor, index = decode_step(predictor, index, nibble)
+        nibbles.append(nibble)
+        error += (sample - predictor) ** 2
+    if len(nibbles) & 1:
+        nibbles.append(0)
+    data = [nibbles[i] | (nibbles[i + 1] << 4) for i in range(0, len(nibbles), 2)]
+    return error, start, data
+
+
+# The start step matters for clips that begin with a transient, try them all
+def encode(samples):
+    best = min((encode_from(samples, index) for index in range(89)), key=lambda e: e[0])
+    return best[1], best[2]
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    out_dir = os.path.join(here, "..", "..", "source", "rubido_fruitjam", "samples")
+    if len(sys.argv) < 2:
+        sys.exit("usage: mksamples.py file.wav [file.wav ...]")
+    for path in sys.argv[1:]:
+        rate, samples = read_wav(path)
+        if rate > 65535 or len(samples) > 65535 or len(samples) < 2:
+            sys.exit("%s: rate and length must fit 16 bits" % path)
+        (predictor, index), data = encode(samples)
+        name = os.path.splitext(os.path.basename(path))[0]
+        with open(os.path.join(out_dir, "%s_ADPCM.h" % name), "w") as f:
+            f.write("// Generated from: %s\n" % os.path.basename(path))
+            f.write("// Format: IMA_ADPCM\n")
+            f.write("// Original size: %d samples at %d Hz = %d bytes, %d bytes encoded\n\n"
+                    % (len(samples), rate, len(samples) * 2, len(data)))
+            f.write("const uint8_t %s_data[] PROGMEM = {\n" % name)
+            lines = ["    " + ", ".join("0x%02X" % b for b in data[i:i + 16]) for i in range(0, len(data), 16)]
+            f.write(",\n".join(lines) + "\n};\n\n")
+            f.write("const AudioSample %s_sample = { %s_data, %d, %d, %d, %d };\n"
+                    % (name, name, len(samples), rate, predictor, index))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+# mksoundbank.py - builds the sound bank headers from sounds.txt
+#
+# Usage: python3 mksoundbank.py [sounds.txt] [output directory]
+# Writes soundbankids.h (effect ids) and soundbankdata.h (the bank) into
+# source/rubido_fruitjam by default.
+#
+# Bank layout, all bytes:
+#   effect count, then a 16 bit little endian offset per effect
+#   effect: track count, then per track: event count, events
+#   event (AUDIO_TRACK_EVENT_BYTES = 6): start tick (16 bit little endian),
+#   MIDI note, duration ticks, waveform << 4 | envelope index, level
+
+import os
+import re
+import sys
+
+TICKS_PER_SECOND = 240
+MAX_TRACKS = 4
+WAVEFORMS = ["sine", "square", "triangle", "saw", "noise"]
+NOTE_NAMES = {"C": 0, "D": 2, "E": 4, "F": 5, "G": 7, "A": 9, "B": 11}
+
+
+def fail(line_no, message):
+    sys.exit("sounds.txt:%d: %s" % (line_no, message))
+
+
+def parse_note(text, line_no):
+    name = text[0].upper()
+    if name not in NOTE_NAMES:
+        fail(line_no, "bad note " + text)
+    rest = text[1:]
+    semitone = NOTE_NAMES[name]
+    if rest.startswith("#"):
+        semitone += 1
+        rest = rest[1:]
+    try:
+        octave = int(rest)
+    except ValueError:
+        fail(line_no, "bad note " + text)
+    note = (octave + 1) * 12 + semitone
+    if note < 0 or note > 127:
+        fail(line_no, "note out of range " + text)
+    return note
+
+
+def ms_to_ticks(ms):
+    return int(ms * TICKS_PER_SECOND / 1000.0 + 0.5)
+
+
+def parse(path):
+    envelopes = []       # (name, attack, decay, sustain, release)
+    effects = []         # (id, [events])
+    for line_no, line in enumerate(open(path), 1):
+        # comments start with a # on its own, C#4 is a note
+        words = re.sub(r"(^|\s)#(\s.*)?$", "", line).split()
+        if not words:
+            continue
+        if words[0] == "envelope" and len(words) == 6:
+            if len(envelopes) == 16:
+                fail(line_no, "at most 16 envelopes")
+            envelopes.append((words[1],) + tuple(int(w) for w in words[2:]))
+        elif words[0] == "effect" and len(words) == 2:
+            effects.append((words[1], []))
+        elif words[0] == "note" and len(words) in (6, 7):
+            if not effects:
+                fail(line_no, "note outside of an effect")
+            start = ms_to_ticks(float(words[1]))
+            note = parse_note(words[2], line_no)
+            duration = ms_to_ticks(float(words[3]))
+            if words[4] not in WAVEFORMS:
+                fail(line_no, "unknown waveform " + words[4])
+            names = [e[0] for e in envelopes]
+            if words[5] not in names:
+                fail(line_no, "unknown envelope " + words[5])
+            level = int(words[6]) if len(words) == 7 else 255
+            if start > 65535 or duration < 1 or duration > 255 or level > 255:
+                fail(line_no, "start, duration or level out of range")
+            effects[-1][1].append((start, note, duration,
+                                   WAVEFORMS.index(words[4]) << 4 | names.index(words[5]), level))
+        else:
+            fail(line_no, "can't parse: " + line.strip())
+    return envelopes, effects
+
+
+# Gives every note the first voice that is done by its start
+def split_tracks(name, events):
+    tracks = []
+    for event in sorted(events, key=lambda e: e[0]):
+        for track in tracks:
+            last = track[-1]
+            if last[0] + last[2] <= event[0]:
+                track.append(event)
+                break
+        else:
+            if len(tracks) == MAX_TRACKS:
+                sys.exit("effect %s needs more than %d voices" % (name, MAX_TRACKS))
+            tracks.append([event])
+    return tracks
+
+
+def build(effects):
+    records = []
+    for name, events in effects:
+        tracks = split_tracks(name, events)
+        record = [len(tracks)]
+        for track in tracks:
+            if len(track) > 255:
+                sys.exit("effect %s has too many notes" % name)
+            record.append(len(track))
+            for start, note, duration, shape, level in track:
+                record += [start & 0xFF, start >> 8, note, duration, shape, level]
+        records.append(record)
+    data = [len(records)]
+    offset = 1 + 2 * len(records)
+    for record in records:
+        data += [offset & 0xFF, offset >> 8]
+        offset += len(record)
+    for record in records:
+        data += record
+    if len(data) > 65535:
+        sys.exit("sound bank too large")
+    return data
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    source = sys.argv[1] if len(sys.argv) > 1 else os.path.join(here, "sounds.txt")
+    out_dir = sys.argv[2] if len(sys.argv) > 2 else os.path.join(here, "..", "..", "source", "rubido_fruitjam")
+    envelopes, effects = parse(source)
+    data = build(effects)
+    source_name = os.path.basename(source)
+
+    with open(os.path.join(out_dir, "soundbankids.h"), "w") as f:
+        f.write("// Generated from: %s by tools/soundbank/mksoundbank.py\n\n" % source_name)
+        f.write("#ifndef SOUNDBANKIDS_H\n#define SOUNDBANKIDS_H\n\n")
+        f.write("enum SoundId {\n")
+        for name, _ in effects:
+            f.write("    SOUND_%s,\n" % name)
+        f.write("    SOUND_COUNT\n};\n#endif\n")
+
+    with open(os.path.join(out_dir, "soundbankdata.h"), "w") as f:
+        f.write("// Generated from: %s by tools/soundbank/mksoundbank.py\n" % source_name)
+        f.write("// %d effects, %d bytes\n\n" % (len(effects), len(data)))
+        f.write("#ifndef SOUNDBANKDATA_H\n#define SOUNDBANKDATA_H\n\n")
+        f.write("#include <stdint.h>\n#include \"audiomixer.h\"\n\n")
+        f.write("static const AudioEnvelope sound_bank_envelopes[] = {\n")
+        for name, attack, decay, sustain, release in envelopes:
+            f.write("    { %d, %d, %d, %d },   // %s\n" % (attack, decay, sustain, release, name))
+        f.write("};\n\n")
+        f.write("static const uint8_t sound_bank[] = {\n")
+        for i in range(0, len(data), 16):
+            f.write("    " + ", ".join("0x%02X" % b for b in data[i:i + 16]) + ",\n")
+        f.write("};\n#endif\n")
+
+
+if __name__ == "__main__":
+    main()